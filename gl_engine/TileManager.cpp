@@ -104,7 +104,7 @@ bool compareTileSetPair(std::pair<float, const TileSet*> t1, std::pair<float, co
     return (t1.first < t2.first);
 }
 
-const nucleus::tile_scheduler::DrawListGenerator::TileSet TileManager::generate_tilelist(const nucleus::camera::Definition& camera) const {
+const nucleus::tile_scheduler::DrawListGenerator::TileSet TileManager::generate_tilelist(const nucleus::camera::Definition& camera) {
     return m_draw_list_generator.generate_for(camera);
 }
 
@@ -250,6 +250,19 @@ void TileManager::add_tile(
     if (!QOpenGLContext::currentContext()) // can happen during shutdown.
         return;
 
+    // tiles that are here already are patched in place (e.g., preliminary ones, once their ortho photo arrived)
+    const auto loaded = std::find(m_loaded_tiles.begin(), m_loaded_tiles.end(), id);
+    if (loaded != m_loaded_tiles.end()) {
+        const auto layer_index = unsigned(loaded - m_loaded_tiles.begin());
+        m_ortho_textures->upload(ortho_texture, layer_index);
+        m_heightmap_textures->upload(height_map, layer_index);
+        const auto tileset = std::find_if(m_gpu_tiles.begin(), m_gpu_tiles.end(), [&id](const TileSet& t) { return t.tile_id == id; });
+        assert(tileset != m_gpu_tiles.end());
+        tileset->bounds = tile::SrsBounds(bounds);
+        emit tiles_changed();
+        return;
+    }
+
     TileSet tileset;
     tileset.tile_id = id;
     tileset.bounds = tile::SrsBounds(bounds);
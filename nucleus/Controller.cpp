@@ -29,12 +29,9 @@
 #include "AbstractRenderWindow.h"
 #include "nucleus/camera/Controller.h"
 #include "nucleus/camera/PositionStorage.h"
-#include "nucleus/tile_scheduler/LayerAssembler.h"
-#include "nucleus/tile_scheduler/QuadAssembler.h"
-#include "nucleus/tile_scheduler/RateLimiter.h"
 #include "nucleus/tile_scheduler/Scheduler.h"
-#include "nucleus/tile_scheduler/SlotLimiter.h"
 #include "nucleus/tile_scheduler/TileLoadService.h"
+#include "nucleus/tile_scheduler/setup.h"
 #include "nucleus/tile_scheduler/utils.h"
 #include "radix/TileHeights.h"
 
@@ -48,17 +45,27 @@ Controller::Controller(AbstractRenderWindow* render_window)
     qRegisterMetaType<nucleus::event_parameter::Mouse>();
     qRegisterMetaType<nucleus::event_parameter::Wheel>();
 
-    m_terrain_service = std::make_unique<TileLoadService>("https://alpinemaps.cg.tuwien.ac.at/tiles/alpine_png/", TileLoadService::UrlPattern::ZXY, ".png");
-    //    m_ortho_service.reset(new TileLoadService("https://tiles.bergfex.at/styles/bergfex-osm/", TileLoadService::UrlPattern::ZXY_yPointingSouth, ".jpeg"));
-    //    m_ortho_service.reset(new TileLoadService("https://alpinemaps.cg.tuwien.ac.at/tiles/ortho/", TileLoadService::UrlPattern::ZYX_yPointingSouth, ".jpeg"));
-    // m_ortho_service.reset(new TileLoadService("https://maps%1.wien.gv.at/basemap/bmaporthofoto30cm/normal/google3857/",
+    // any TileSource can be plugged in here, e.g., DirectoryTileSource or MbTilesTileSource (with qt sql) for offline use.
+    auto terrain_service = std::make_unique<TileLoadService>("https://alpinemaps.cg.tuwien.ac.at/tiles/alpine_png/", TileLoadService::UrlPattern::ZXY, ".png");
+    //    auto ortho_service = std::make_unique<TileLoadService>("https://tiles.bergfex.at/styles/bergfex-osm/", TileLoadService::UrlPattern::ZXY_yPointingSouth, ".jpeg");
+    //    auto ortho_service = std::make_unique<TileLoadService>("https://alpinemaps.cg.tuwien.ac.at/tiles/ortho/", TileLoadService::UrlPattern::ZYX_yPointingSouth, ".jpeg");
+    // auto ortho_service = std::make_unique<TileLoadService>("https://maps%1.wien.gv.at/basemap/bmaporthofoto30cm/normal/google3857/",
     //                                           TileLoadService::UrlPattern::ZYX_yPointingSouth,
     //                                           ".jpeg",
-    //                                           {"", "1", "2", "3", "4"}));
-    m_ortho_service.reset(
-        new TileLoadService("https://gataki.cg.tuwien.ac.at/raw/basemap/tiles/", TileLoadService::UrlPattern::ZYX_yPointingSouth, ".jpeg"));
+    //                                           TileLoadService::LoadBalancingTargets {"", "1", "2", "3", "4"});
+    auto ortho_service
+        = std::make_unique<TileLoadService>("https://gataki.cg.tuwien.ac.at/raw/basemap/tiles/", TileLoadService::UrlPattern::ZYX_yPointingSouth, ".jpeg");
+    // one connection pool (and dns / tls session cache) for both layers. http/2 is negotiated where the server supports it.
+    m_network_manager = std::make_shared<QNetworkAccessManager>();
+    terrain_service->set_network_manager(m_network_manager);
+    ortho_service->set_network_manager(m_network_manager);
+    m_terrain_service = std::move(terrain_service);
+    m_ortho_service = std::move(ortho_service);
 
     m_tile_scheduler = std::make_unique<nucleus::tile_scheduler::Scheduler>();
+#ifdef ALP_ENABLE_DECODED_DISK_CACHE
+    m_tile_scheduler->set_decoded_disk_cache_enabled(true);
+#endif
     m_tile_scheduler->read_disk_cache();
     m_render_window->set_quad_limit(512); // must be same as scheduler, dynamic resizing is not supported atm
     m_tile_scheduler->set_gpu_quad_limit(512);
@@ -78,25 +85,7 @@ Controller::Controller(AbstractRenderWindow* render_window)
         nucleus::camera::PositionStorage::instance()->get("grossglockner"),
         m_render_window->depth_tester(),
         m_data_querier.get());
-    {
-        auto* sch = m_tile_scheduler.get();
-        SlotLimiter* sl = new SlotLimiter(sch);
-        RateLimiter* rl = new RateLimiter(sch);
-        QuadAssembler* qa = new QuadAssembler(sch);
-        LayerAssembler* la = new LayerAssembler(sch);
-        connect(sch, &Scheduler::quads_requested, sl, &SlotLimiter::request_quads);
-        connect(sl, &SlotLimiter::quad_requested, rl, &RateLimiter::request_quad);
-        connect(rl, &RateLimiter::quad_requested, qa, &QuadAssembler::load);
-        connect(qa, &QuadAssembler::tile_requested, la, &LayerAssembler::load);
-        connect(la, &LayerAssembler::tile_requested, m_ortho_service.get(), &TileLoadService::load);
-        connect(la, &LayerAssembler::tile_requested, m_terrain_service.get(), &TileLoadService::load);
-
-        connect(m_ortho_service.get(), &TileLoadService::load_finished, la, &LayerAssembler::deliver_ortho);
-        connect(m_terrain_service.get(), &TileLoadService::load_finished, la, &LayerAssembler::deliver_height);
-        connect(la, &LayerAssembler::tile_loaded, qa, &QuadAssembler::deliver_tile);
-        connect(qa, &QuadAssembler::quad_loaded, sl, &SlotLimiter::deliver_quad);
-        connect(sl, &SlotLimiter::quad_delivered, sch, &Scheduler::receive_quad);
-    }
+    tile_scheduler::setup::connect_pipeline(m_tile_scheduler.get(), m_ortho_service.get(), m_terrain_service.get());
     if (QNetworkInformation::loadDefaultBackend() && QNetworkInformation::instance()) {
         QNetworkInformation* n = QNetworkInformation::instance();
         m_tile_scheduler->set_network_reachability(n->reachability());
@@ -108,9 +97,11 @@ Controller::Controller(AbstractRenderWindow* render_window)
     m_scheduler_thread->setObjectName("tile_scheduler_thread");
     qDebug() << "scheduler thread: " << m_scheduler_thread.get();
 #ifdef __EMSCRIPTEN__ // make request from main thread on webassembly due to QTBUG-109396
+    m_network_manager->moveToThread(QCoreApplication::instance()->thread());
     m_terrain_service->moveToThread(QCoreApplication::instance()->thread());
     m_ortho_service->moveToThread(QCoreApplication::instance()->thread());
 #else
+    m_network_manager->moveToThread(m_scheduler_thread.get());
     m_terrain_service->moveToThread(m_scheduler_thread.get());
     m_ortho_service->moveToThread(m_scheduler_thread.get());
 #endif
@@ -127,6 +118,8 @@ Controller::Controller(AbstractRenderWindow* render_window)
     // At the time of writing, an additional connection from tile_ready and tile_expired to the notifier is made.
     // this only works if ALP_ENABLE_THREADING is on, i.e., the tile scheduler is on an extra thread. -> potential issue on webassembly
     connect(m_camera_controller.get(), &nucleus::camera::Controller::definition_changed, m_tile_scheduler.get(), &Scheduler::update_camera);
+    connect(m_camera_controller.get(), &nucleus::camera::Controller::animation_target_changed, m_tile_scheduler.get(), &Scheduler::update_animation_target);
+    connect(m_camera_controller.get(), &nucleus::camera::Controller::animation_stopped, m_tile_scheduler.get(), &Scheduler::clear_animation_target);
     connect(m_camera_controller.get(), &nucleus::camera::Controller::definition_changed, m_render_window, &AbstractRenderWindow::update_camera);
 
     connect(m_tile_scheduler.get(), &Scheduler::gpu_quads_updated, m_render_window, &AbstractRenderWindow::update_gpu_quads);
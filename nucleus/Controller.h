@@ -26,7 +26,7 @@ namespace nucleus {
 class AbstractRenderWindow;
 class DataQuerier;
 namespace tile_scheduler {
-class TileLoadService;
+class TileSource;
 class Scheduler;
 }
 namespace camera {
@@ -45,12 +45,12 @@ public:
 
 private:
     AbstractRenderWindow* m_render_window;
-    QNetworkAccessManager m_network_manager;
+    std::shared_ptr<QNetworkAccessManager> m_network_manager;
 #ifdef ALP_ENABLE_THREADING
     std::unique_ptr<QThread> m_scheduler_thread;
 #endif
-    std::unique_ptr<tile_scheduler::TileLoadService> m_terrain_service;
-    std::unique_ptr<tile_scheduler::TileLoadService> m_ortho_service;
+    std::unique_ptr<tile_scheduler::TileSource> m_terrain_service;
+    std::unique_ptr<tile_scheduler::TileSource> m_ortho_service;
     std::unique_ptr<tile_scheduler::Scheduler> m_tile_scheduler;
     std::unique_ptr<DataQuerier> m_data_querier;
     std::unique_ptr<camera::Controller> m_camera_controller;
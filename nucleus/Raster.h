@@ -23,6 +23,7 @@
 #include <vector>
 
 #include <glm/glm.hpp>
+#include <zpp_bits.h>
 
 namespace nucleus {
 
@@ -33,6 +34,9 @@ class Raster {
     size_t m_height = 0;
 
 public:
+    friend zpp::bits::access;
+    using serialize = zpp::bits::members<3>;
+
     Raster() = default;
     Raster(size_t square_side_length, std::vector<T>&& vector)
         : m_data(std::move(vector))
@@ -34,3 +34,8 @@ std::optional<float> AnimationStyle::operation_centre_distance(Definition)
 {
     return {};
 }
+
+std::optional<Definition> AnimationStyle::end_camera() const
+{
+    return {};
+}
@@ -32,6 +32,8 @@ public:
     virtual std::optional<Definition> update(Definition camera, AbstractDepthTester* depth_tester);
     virtual std::optional<glm::vec2> operation_centre();
     virtual std::optional<float> operation_centre_distance(Definition camera);
+    /// where the camera will be once the animation is finished, if known in advance (used for prefetching tiles).
+    virtual std::optional<Definition> end_camera() const;
 };
 
 } // namespace nucleus::camera
@@ -74,13 +74,13 @@ void Controller::fly_to_latitude_longitude(double latitude, double longitude)
     auto end_camera = m_definition;
     end_camera.look_at(camera_position, look_at_point);
 
-    m_animation_style = std::make_unique<LinearCameraAnimation>(m_definition, end_camera);
+    set_animation_style(std::make_unique<LinearCameraAnimation>(m_definition, end_camera));
     update();
 }
 
 void Controller::rotate_north()
 {
-    m_animation_style = std::make_unique<RotateNorthAnimation>(m_definition, m_depth_tester);
+    set_animation_style(std::make_unique<RotateNorthAnimation>(m_definition, m_depth_tester));
     update();
 }
 
@@ -117,10 +117,8 @@ void Controller::mouse_press(const event_parameter::Mouse& e)
 {
     report_global_cursor_position(e.point.position());
 
-    if (m_animation_style) {
-        m_animation_style.reset();
-        m_interaction_style->reset_interaction(m_definition, m_depth_tester);
-    }
+    if (m_animation_style)
+        stop_animation();
 
     const auto new_definition = m_interaction_style->mouse_press_event(e, m_definition, m_depth_tester);
     if (!new_definition)
@@ -131,10 +129,8 @@ void Controller::mouse_press(const event_parameter::Mouse& e)
 
 void Controller::mouse_move(const event_parameter::Mouse& e)
 {
-    if (m_animation_style) {
-        m_animation_style.reset();
-        m_interaction_style->reset_interaction(m_definition, m_depth_tester);
-    }
+    if (m_animation_style)
+        stop_animation();
     const auto new_definition = m_interaction_style->mouse_move_event(e, m_definition, m_depth_tester);
     if (!new_definition)
         return;
@@ -146,10 +142,8 @@ void Controller::mouse_move(const event_parameter::Mouse& e)
 
 void Controller::wheel_turn(const event_parameter::Wheel& e)
 {
-    if (m_animation_style) {
-        m_animation_style.reset();
-        m_interaction_style->reset_interaction(m_definition, m_depth_tester);
-    }
+    if (m_animation_style)
+        stop_animation();
 
     const auto new_definition = m_interaction_style->wheel_event(e, m_definition, m_depth_tester);
     if (!new_definition)
@@ -160,10 +154,8 @@ void Controller::wheel_turn(const event_parameter::Wheel& e)
 
 void Controller::key_press(const QKeyCombination& e)
 {
-    if (m_animation_style) {
-        m_animation_style.reset();
-        m_interaction_style->reset_interaction(m_definition, m_depth_tester);
-    }
+    if (m_animation_style)
+        stop_animation();
 
     if (e.key() == Qt::Key_1) {
         m_interaction_style = std::make_unique<OrbitInteraction>();
@@ -195,10 +187,8 @@ void Controller::key_release(const QKeyCombination& e)
 
 void Controller::touch(const event_parameter::Touch& e)
 {
-    if (m_animation_style) {
-        m_animation_style.reset();
-        m_interaction_style->reset_interaction(m_definition, m_depth_tester);
-    }
+    if (m_animation_style)
+        stop_animation();
 
     const auto new_definition = m_interaction_style->touch_event(e, m_definition, m_depth_tester);
     if (!new_definition)
@@ -212,8 +202,7 @@ void Controller::update_camera_request()
     if (m_animation_style) {
         const auto new_camera_definition = m_animation_style->update(m_definition, m_depth_tester);
         if (!new_camera_definition) {
-            m_animation_style.reset();
-            m_interaction_style->reset_interaction(m_definition, m_depth_tester);
+            stop_animation();
             return;
         }
         m_definition = new_camera_definition.value();
@@ -227,6 +216,23 @@ void Controller::update_camera_request()
     }
 }
 
+void Controller::set_animation_style(std::unique_ptr<AnimationStyle> new_style)
+{
+    m_animation_style = std::move(new_style);
+    const auto end_camera = m_animation_style->end_camera();
+    if (end_camera)
+        emit animation_target_changed(end_camera.value());
+    else
+        emit animation_stopped(); // a previous target is not valid anymore
+}
+
+void Controller::stop_animation()
+{
+    m_animation_style.reset();
+    m_interaction_style->reset_interaction(m_definition, m_depth_tester);
+    emit animation_stopped();
+}
+
 std::optional<glm::vec2> Controller::operation_centre()
 {
     if (m_animation_style) {
@@ -74,11 +74,15 @@ public slots:
 
 signals:
     void definition_changed(const Definition& new_definition) const;
+    /// emitted when an animation with a known end camera starts, e.g., on fly-to.
+    void animation_target_changed(const Definition& end_camera) const;
+    void animation_stopped() const;
     void global_cursor_position_changed(glm::dvec3 pos) const;
 
 private:
     void set_interaction_style(std::unique_ptr<InteractionStyle> new_style);
-    void set_animation_style(std::unique_ptr<InteractionStyle> new_style);
+    void set_animation_style(std::unique_ptr<AnimationStyle> new_style);
+    void stop_animation();
 
     Definition m_definition;
     AbstractDepthTester* m_depth_tester;
@@ -27,6 +27,7 @@ namespace nucleus::camera {
 LinearCameraAnimation::LinearCameraAnimation(Definition start, Definition end)
     : m_start(start.camera_space_to_world_matrix())
     , m_end(end.camera_space_to_world_matrix())
+    , m_end_camera(end)
 {
     m_current_duration = 0;
     m_stopwatch.restart();
@@ -54,6 +55,11 @@ std::optional<Definition> LinearCameraAnimation::update(Definition camera, Abstr
     return camera;
 }
 
+std::optional<Definition> LinearCameraAnimation::end_camera() const
+{
+    return m_end_camera;
+}
+
 float LinearCameraAnimation::ease_in_out(float t)
 {
     // this one is untested, but works for now
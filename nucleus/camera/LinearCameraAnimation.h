@@ -28,6 +28,7 @@ class LinearCameraAnimation : public AnimationStyle
     utils::Stopwatch m_stopwatch = {};
     glm::dmat4 m_start;
     glm::dmat4 m_end;
+    Definition m_end_camera;
 
     int m_total_duration = 250;
     float m_current_duration = 0;
@@ -35,6 +36,7 @@ class LinearCameraAnimation : public AnimationStyle
 public:
     LinearCameraAnimation(Definition start, Definition end);
     std::optional<Definition> update(Definition camera, AbstractDepthTester* depth_tester) override;
+    std::optional<Definition> end_camera() const override;
 
 private:
     float ease_in_out(float t);
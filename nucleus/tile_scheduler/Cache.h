@@ -19,13 +19,27 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
 #include <filesystem>
+#include <limits>
 #include <mutex>
+#include <optional>
 #include <shared_mutex>
+#include <span>
 #include <unordered_set>
 #include <vector>
 
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <QDebug>
 #include <QFile>
+#include <QSaveFile>
 #include <fmt/format.h>
 #include <tl/expected.hpp>
 #include <zpp_bits.h>
@@ -48,11 +62,26 @@ constexpr auto serialize(auto & archive, glm::vec<2, T> & vec)
     return archive(vec.x, vec.y);
 }
 
+template<typename T>
+constexpr auto serialize(auto & archive, const glm::vec<3, T> & vec)
+{
+    return archive(vec.x, vec.y, vec.z);
+}
+
+template<typename T>
+constexpr auto serialize(auto & archive, glm::vec<3, T> & vec)
+{
+    return archive(vec.x, vec.y, vec.z);
+}
+
 }
 
 namespace nucleus::tile_scheduler {
 
-/// This class is thread safe. be careful with the visit method as it writes the cache and therefore locks an internal mutex.
+/// This class is thread safe. Objects are distributed over shards, each guarded by its own mutex.
+/// visit takes shared locks on all shards, so traversals run concurrently with each other and with peak_at, but block inserts.
+/// Don't do heavy lifting in the visitor, as it blocks all inserts and purges.
+/// Tiles read from disk are paged in lazily, i.e., only when they are visited or peaked at.
 template<tile_types::NamedTile T>
 class Cache
 {
@@ -61,14 +90,105 @@ class Cache
         uint64_t created;
     };
 
+    /// position of a serialised tile inside the pack file
+    struct DiskLocation {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+    };
+
+    // std::atomic is not copyable, but cache objects are copied into snapshots for writing to disk.
+    template <typename V>
+    struct CopyableAtomic : public std::atomic<V> {
+        CopyableAtomic(V value = {})
+            : std::atomic<V>(value)
+        {
+        }
+        CopyableAtomic(const CopyableAtomic& other)
+            : std::atomic<V>(other.load(std::memory_order_relaxed))
+        {
+        }
+        CopyableAtomic& operator=(const CopyableAtomic& other)
+        {
+            this->store(other.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            return *this;
+        }
+    };
+
     struct CacheObject {
-        MetaData meta;
+        // written by visitors under a shared lock
+        CopyableAtomic<uint64_t> visited = 0;
+        uint64_t created = 0;
         T data;
+        // valid as long as the tile was not paged in from the mapped pack file. data contains only the id in that case.
+        // paging in happens under a shared lock, hence data must only be read after seeing paged_out == false.
+        DiskLocation disk_location;
+        CopyableAtomic<bool> paged_out = false;
+        // links into the quad tree, so that traversals don't have to hash. objects are never moved inside the unordered_map.
+        // children are in the order of tile::Id::children(). changes require exclusive locks on the shards of both ends.
+        CacheObject* parent = nullptr;
+        std::array<CacheObject*, 4> children = {};
+
+        MetaData meta() const { return { visited.load(std::memory_order_relaxed), created }; }
+    };
+
+    struct EvictionEntry {
+        uint64_t visited;
+        tile::Id id;
+    };
+    static bool later_visited(const EvictionEntry& a, const EvictionEntry& b) { return a.visited > b.visited; }
+
+    struct Shard {
+        // mutable, because tiles are paged in on read access.
+        mutable std::unordered_map<tile::Id, CacheObject, tile::Id::Hasher> data;
+        // min heap on the visited stamp with at least one entry per object. visits don't touch it (they run under a shared lock),
+        // so entries can be older than the object's stamp. purge refreshes such entries when they come up (lazy update).
+        // erase leaves the entry behind, purge drops it once it comes up. the heap is rebuilt if there are too many of them.
+        std::vector<EvictionEntry> eviction_queue;
+        // changes since the last write to disk, so that only those have to be journaled.
+        std::unordered_set<tile::Id, tile::Id::Hasher> dirty;
+        std::unordered_set<tile::Id, tile::Id::Hasher> evicted;
+        // change on page in, which happens under a shared lock
+        mutable std::atomic<uint64_t> n_bytes = 0;
+        mutable std::atomic<uint64_t> n_stored_bytes = 0;
+        mutable std::shared_mutex mutex;
+    };
+    static constexpr unsigned n_shards = 16;
+    static constexpr unsigned n_shard_bits = 4;
+    static_assert(n_shards == 1u << n_shard_bits);
+    using SharedLocks = std::array<std::shared_lock<std::shared_mutex>, n_shards>;
+    using UniqueLocks = std::array<std::unique_lock<std::shared_mutex>, n_shards>;
+
+    struct DiskIndexEntry {
+        MetaData meta;
+        DiskLocation location;
+    };
+    using DiskIndex = std::unordered_map<tile::Id, DiskIndexEntry, tile::Id::Hasher>;
+    using VersionInformation = std::array<char, 25>;
+    static constexpr VersionInformation pack_format_version = { "alp tile pack, version 2" };
+
+    enum class JournalOperation : uint32_t {
+        Put = 0,
+        Erase = 1,
+    };
+    struct JournalRecord {
+        JournalOperation operation = JournalOperation::Put;
+        tile::Id id;
+        MetaData meta = {};
+        DiskLocation location;
     };
 
-    std::unordered_map<tile::Id, CacheObject, tile::Id::Hasher> m_data;
-    mutable std::shared_mutex m_data_mutex;
-    std::unordered_map<tile::Id, MetaData, tile::Id::Hasher> m_disk_cached;
+    std::array<Shard, n_shards> m_shards;
+    // the pack file stays mapped for tiles that are not paged in yet. lock order: shards (ascending) before m_pack_mutex.
+    std::shared_ptr<QFile> m_pack_file;
+    std::span<const uchar> m_pack_mapping;
+    mutable std::mutex m_pack_mutex;
+    // lock order: m_disk_cached_mutex before shards.
+    DiskIndex m_disk_cached;
+    uint64_t m_disk_generation = 0;
+    uint64_t m_disk_pack_size = 0;
+    uint64_t m_disk_live_bytes = 0;
+    uint64_t m_disk_journal_size = 0;
+    uint64_t m_disk_journal_records = 0;
     mutable std::shared_mutex m_disk_cached_mutex;
 
 public:
@@ -76,30 +196,121 @@ public:
     void insert(const T& tile);
     [[nodiscard]] bool contains(const tile::Id& id) const;
     [[nodiscard]] unsigned n_cached_objects() const;
-    /// functor should return true, if the given tile should be marked visited. stops descending if false is returned. don't do heavy lifting in the functort, as it blocks all other access!
+    /// estimated memory used by the cached objects, including the payload of SizedTiles and the bookkeeping of the cache.
+    [[nodiscard]] uint64_t n_bytes() const;
+    /// estimated size of the tiles themselves, including the ones that are paged out (those count with their size in the pack).
+    /// unlike n_bytes, this bounds the size of the disk cache.
+    [[nodiscard]] uint64_t n_stored_bytes() const;
+    /// functor should return true, if the given tile should be marked visited. stops descending if false is returned.
+    /// several visits can run in parallel, the functor must be safe for that if it is shared.
     template<typename VisitorFunction>
     void visit(const VisitorFunction& functor);
-    const T& peak_at(const tile::Id& id) const;
-    std::vector<T> purge(unsigned remaining_capacity);
+    /// like visit, but starts at root instead of the root of the quad tree. does nothing if root is not cached.
+    /// the ancestors of root are neither checked nor marked visited.
+    template<typename VisitorFunction>
+    void visit_subtree(const tile::Id& root, const VisitorFunction& functor);
+    /// returns a copy of the tile, or nothing if there is no such tile or it couldn't be paged in (e.g., the pack file is corrupt).
+    [[nodiscard]] std::optional<T> peak_at(const tile::Id& id) const;
+    /// marks the tile as recently used, like a visit. unlike insert, the tile is not written to disk again.
+    /// returns false, if there was no such tile.
+    bool touch(const tile::Id& id);
+    /// returns false, if there was no such tile.
+    bool erase(const tile::Id& id);
+    /// purges the least recently visited tiles until at most remaining_capacity tiles, remaining_bytes (see n_bytes) and
+    /// remaining_stored_bytes (see n_stored_bytes) are left.
+    /// returns the purged tiles. tiles that were never paged in from disk carry only their id.
+    std::vector<T> purge(unsigned remaining_capacity, uint64_t remaining_bytes = std::numeric_limits<uint64_t>::max(),
+        uint64_t remaining_stored_bytes = std::numeric_limits<uint64_t>::max());
+    [[nodiscard]] unsigned n_paged_out_objects() const;
 
     [[nodiscard]] tl::expected<void, std::string> write_to_disk(const std::filesystem::path& path);
+    /// reads only the index, tiles are paged in on demand.
     [[nodiscard]] tl::expected<void, std::string> read_from_disk(const std::filesystem::path& path);
+    /// removes the pack and journal files written by write_to_disk. other files and directories in path are left alone.
+    static void remove_from_disk(const std::filesystem::path& path);
 
 private:
     template<typename VisitorFunction>
-    void visit(const tile::Id& start_node,
-               const VisitorFunction& functor,
-               uint64_t visited_stamp); // must stay private or protected by mutex
+    void visit(CacheObject* node, const VisitorFunction& functor, uint64_t visited_stamp); // must stay private or protected by mutex
+    CacheObject* find(const tile::Id& id) const; // requires a lock on the shard of id
+    void link(const tile::Id& id, CacheObject* object); // requires exclusive locks on the shards of id, its parent and its children
+    void unlink(CacheObject* object); // same as link
+    static size_t child_slot(const tile::Id& parent, const tile::Id& child)
+    {
+        const auto siblings = parent.children();
+        return size_t(std::find(siblings.cbegin(), siblings.cend(), child) - siblings.cbegin());
+    }
+    bool page_in(CacheObject* object) const; // requires at least a shared lock on the object's shard
+    static uint64_t size_of(const CacheObject& object)
+    {
+        // node of the unordered_map and its bucket
+        constexpr auto overhead = uint64_t(sizeof(CacheObject) + sizeof(tile::Id) + 3 * sizeof(void*));
+        if constexpr (tile_types::SizedTile<T>) {
+            if (!object.paged_out.load(std::memory_order_relaxed))
+                return overhead + object.data.size_in_bytes() - sizeof(T);
+        }
+        return overhead;
+    }
+    static uint64_t stored_size_of(const CacheObject& object)
+    {
+        if (object.paged_out.load(std::memory_order_relaxed))
+            return object.disk_location.size;
+        if constexpr (tile_types::SizedTile<T>)
+            return object.data.size_in_bytes();
+        else
+            return sizeof(T);
+    }
 
-    static std::filesystem::path tile_path(const std::filesystem::path& base_path, const tile::Id& id)
+    Shard& shard_for(const tile::Id& id) { return m_shards[shard_index(id)]; }
+    const Shard& shard_for(const tile::Id& id) const { return m_shards[shard_index(id)]; }
+    static unsigned shard_index(const tile::Id& id)
     {
-        return base_path / fmt::format("{}_{}_{}.alp_tile", id.zoom_level, id.coords.x, id.coords.y);
+        // fibonacci hashing, the upper bits are well distributed even if the hasher is not.
+        return unsigned((uint64_t(tile::Id::Hasher()(id)) * 0x9E3779B97F4A7C15ull) >> (64 - n_shard_bits));
     }
+    /// locks the shards of the tile, its parent and its children (in ascending order, as always).
+    UniqueLocks lock_neighbourhood(const tile::Id& id)
+    {
+        std::array<bool, n_shards> needed = {};
+        needed[shard_index(id)] = true;
+        if (id.zoom_level > 0)
+            needed[shard_index(id.parent())] = true;
+        for (const auto& child : id.children())
+            needed[shard_index(child)] = true;
+        UniqueLocks locks;
+        for (unsigned i = 0; i < n_shards; ++i) {
+            if (needed[i])
+                locks[i] = std::unique_lock(m_shards[i].mutex);
+        }
+        return locks;
+    }
+    template <typename Locks>
+    Locks lock_all_shards() const
+    {
+        Locks locks;
+        for (unsigned i = 0; i < n_shards; ++i)
+            locks[i] = typename Locks::value_type(m_shards[i].mutex);
+        return locks;
+    }
+
+    [[nodiscard]] tl::expected<void, std::string> append_to_disk(const std::filesystem::path& base_path);
+    [[nodiscard]] tl::expected<void, std::string> rewrite_disk(const std::filesystem::path& base_path);
+    void invalidate_disk_state();
 
-    static std::filesystem::path meta_info_path(const std::filesystem::path& base_path)
+    static tl::expected<void, std::string> append_file(const std::filesystem::path& path, const std::vector<char>& bytes);
+    static tl::expected<void, std::string> save_file(const std::filesystem::path& path, const std::vector<char>& bytes);
+    template <typename Archive>
+    static tl::expected<void, std::string> write_header(Archive* out, uint64_t generation);
+    template <typename Archive>
+    static tl::expected<uint64_t, std::string> check_header(Archive* in, const std::filesystem::path& path);
+
+    // all tiles live in one append only pack file. the journal records where tiles are put into the pack and when they are erased.
+    // rewriting the pack creates a new generation, so that the old one can stay mapped until the new one is committed.
+    static std::filesystem::path pack_path(const std::filesystem::path& base_path, uint64_t generation)
     {
-        return base_path / "meta_info.alp";
+        return base_path / fmt::format("tiles_{}.alp_pack", generation);
     }
+    static std::filesystem::path journal_path(const std::filesystem::path& base_path) { return base_path / "tiles.alp_journal"; }
 };
 
 using MemoryCache = nucleus::tile_scheduler::Cache<nucleus::tile_scheduler::tile_types::TileQuad>;
@@ -107,32 +318,289 @@ using MemoryCache = nucleus::tile_scheduler::Cache<nucleus::tile_scheduler::tile
 template <tile_types::NamedTile T>
 void Cache<T>::insert(const T& tile)
 {
-    auto locker = std::scoped_lock(m_data_mutex);
+    Shard& shard = shard_for(tile.id);
+    const auto locks = lock_neighbourhood(tile.id);
     const auto time_stamp = utils::time_since_epoch();
-    m_data[tile.id].meta.visited = time_stamp * 100 - tile.id.zoom_level;
-    m_data[tile.id].meta.created = time_stamp;
-    m_data[tile.id].data = tile;
+    const auto [iter, inserted] = shard.data.try_emplace(tile.id);
+    CacheObject& object = iter->second;
+    if (!inserted) {
+        shard.n_bytes -= size_of(object);
+        shard.n_stored_bytes -= stored_size_of(object);
+    }
+    object.visited.store(time_stamp * 100 - tile.id.zoom_level);
+    object.created = time_stamp;
+    object.data = tile;
+    object.paged_out.store(false);
+    shard.n_bytes += size_of(object);
+    shard.n_stored_bytes += stored_size_of(object);
+    if (inserted) {
+        link(tile.id, &object);
+        if (shard.eviction_queue.size() > 2 * shard.data.size() + 64) {
+            // too many entries were left behind by erase
+            shard.eviction_queue.clear();
+            for (const auto& entry : shard.data)
+                shard.eviction_queue.push_back({ entry.second.visited.load(std::memory_order_relaxed), entry.first });
+            std::make_heap(shard.eviction_queue.begin(), shard.eviction_queue.end(), later_visited);
+        } else {
+            shard.eviction_queue.push_back({ object.visited.load(std::memory_order_relaxed), tile.id });
+            std::push_heap(shard.eviction_queue.begin(), shard.eviction_queue.end(), later_visited);
+        }
+    }
+    shard.dirty.insert(tile.id);
+    shard.evicted.erase(tile.id);
 }
 
 template <tile_types::NamedTile T>
 bool Cache<T>::contains(const tile::Id& id) const
 {
-    auto locker = std::shared_lock(m_data_mutex);
-    return m_data.contains(id);
+    const Shard& shard = shard_for(id);
+    auto locker = std::shared_lock(shard.mutex);
+    return shard.data.contains(id);
 }
 
 template <tile_types::NamedTile T>
 unsigned int Cache<T>::n_cached_objects() const
 {
-    auto locker = std::shared_lock(m_data_mutex);
-    return unsigned(m_data.size());
+    unsigned n = 0;
+    for (const Shard& shard : m_shards) {
+        auto locker = std::shared_lock(shard.mutex);
+        n += unsigned(shard.data.size());
+    }
+    return n;
+}
+
+template <tile_types::NamedTile T>
+uint64_t Cache<T>::n_bytes() const
+{
+    uint64_t n = 0;
+    for (const Shard& shard : m_shards)
+        n += shard.n_bytes.load();
+    return n;
+}
+
+template <tile_types::NamedTile T>
+uint64_t Cache<T>::n_stored_bytes() const
+{
+    uint64_t n = 0;
+    for (const Shard& shard : m_shards)
+        n += shard.n_stored_bytes.load();
+    return n;
+}
+
+template <tile_types::NamedTile T>
+std::optional<T> Cache<T>::peak_at(const tile::Id& id) const
+{
+    const Shard& shard = shard_for(id);
+    auto locker = std::shared_lock(shard.mutex);
+    const auto entry = shard.data.find(id);
+    if (entry == shard.data.end() || !page_in(&entry->second))
+        return {};
+    return entry->second.data;
 }
 
 template <tile_types::NamedTile T>
-const T& Cache<T>::peak_at(const tile::Id& id) const
+bool Cache<T>::touch(const tile::Id& id)
 {
-    auto locker = std::shared_lock(m_data_mutex);
-    return m_data.at(id).data;
+    // like visits, this doesn't touch the eviction queue. purge picks the new stamp up when the entry comes up.
+    const Shard& shard = shard_for(id);
+    auto locker = std::shared_lock(shard.mutex);
+    const auto entry = shard.data.find(id);
+    if (entry == shard.data.end())
+        return false;
+    entry->second.visited.store(utils::time_since_epoch() * 100 - id.zoom_level, std::memory_order_relaxed);
+    return true;
+}
+
+template <tile_types::NamedTile T>
+bool Cache<T>::erase(const tile::Id& id)
+{
+    Shard& shard = shard_for(id);
+    const auto locks = lock_neighbourhood(id);
+    const auto entry = shard.data.find(id);
+    if (entry == shard.data.end())
+        return false;
+    shard.n_bytes -= size_of(entry->second);
+    shard.n_stored_bytes -= stored_size_of(entry->second);
+    unlink(&entry->second);
+    shard.data.erase(entry);
+    shard.dirty.erase(id);
+    shard.evicted.insert(id);
+    return true;
+}
+
+template <tile_types::NamedTile T>
+unsigned Cache<T>::n_paged_out_objects() const
+{
+    unsigned n = 0;
+    for (const Shard& shard : m_shards) {
+        auto locker = std::shared_lock(shard.mutex);
+        n += unsigned(std::count_if(shard.data.cbegin(), shard.data.cend(), [](const auto& entry) { return entry.second.paged_out.load(); }));
+    }
+    return n;
+}
+
+template <tile_types::NamedTile T>
+typename Cache<T>::CacheObject* Cache<T>::find(const tile::Id& id) const
+{
+    const Shard& shard = shard_for(id);
+    const auto entry = shard.data.find(id);
+    if (entry == shard.data.end())
+        return nullptr;
+    return &entry->second;
+}
+
+template <tile_types::NamedTile T>
+void Cache<T>::link(const tile::Id& id, CacheObject* object)
+{
+    if (id.zoom_level > 0) {
+        const auto parent_id = id.parent();
+        if (CacheObject* parent = find(parent_id)) {
+            parent->children[child_slot(parent_id, id)] = object;
+            object->parent = parent;
+        }
+    }
+    const auto children = id.children();
+    for (size_t i = 0; i < children.size(); ++i) {
+        if (CacheObject* child = find(children[i])) {
+            object->children[i] = child;
+            child->parent = object;
+        }
+    }
+}
+
+template <tile_types::NamedTile T>
+void Cache<T>::unlink(CacheObject* object)
+{
+    if (object->parent)
+        std::replace(object->parent->children.begin(), object->parent->children.end(), object, static_cast<CacheObject*>(nullptr));
+    for (CacheObject* child : object->children) {
+        if (child)
+            child->parent = nullptr;
+    }
+    object->parent = nullptr;
+    object->children = {};
+}
+
+template <tile_types::NamedTile T>
+bool Cache<T>::page_in(CacheObject* object) const
+{
+    if (!object->paged_out.load(std::memory_order_acquire))
+        return true;
+    if constexpr (tile_types::SerialisableTile<T>) {
+        // other readers of the same shard may race for the same tile, the pack mutex serialises them.
+        auto locker = std::scoped_lock(m_pack_mutex);
+        if (!object->paged_out.load(std::memory_order_relaxed))
+            return true;
+        const DiskLocation location = object->disk_location;
+        const auto& id = object->data.id;
+        const auto log_failure = [&]() {
+            qWarning() << QString::fromStdString(fmt::format(
+                "Couldn't page in tile {}/{}/{} (offset {}, size {}), the pack file is corrupt.", id.zoom_level, id.coords.x, id.coords.y, location.offset, location.size));
+            return false;
+        };
+        if (location.offset + location.size > m_pack_mapping.size())
+            return log_failure();
+        const auto record = m_pack_mapping.subspan(size_t(location.offset), size_t(location.size));
+        zpp::bits::in in(record);
+        T data;
+        if (failure(in(data)) || data.id != id)
+            return log_failure();
+        const auto size_before = size_of(*object);
+        const auto stored_size_before = stored_size_of(*object);
+        object->data = std::move(data);
+        object->paged_out.store(false, std::memory_order_release);
+        const Shard& shard = shard_for(object->data.id);
+        shard.n_bytes += size_of(*object) - size_before;
+        shard.n_stored_bytes += stored_size_of(*object) - stored_size_before;
+        return true;
+    } else {
+        return false; // only serialisable tiles are read from disk
+    }
+}
+
+template <tile_types::NamedTile T>
+tl::expected<void, std::string> Cache<T>::append_file(const std::filesystem::path& path, const std::vector<char>& bytes)
+{
+    if (bytes.empty())
+        return {};
+    QFile file(path);
+    if (!file.open(QIODeviceBase::WriteOnly | QIODeviceBase::Append))
+        return tl::unexpected<std::string>(fmt::format("Couldn't open file '{}' for appending!", path.string()));
+    if (file.write(bytes.data(), qint64(bytes.size())) != qint64(bytes.size()))
+        return tl::unexpected<std::string>(fmt::format("Couldn't append to file '{}'!", path.string()));
+    // the journal must not reference pack data that isn't on disk yet. QSaveFile::commit syncs on its own.
+    if (!file.flush())
+        return tl::unexpected<std::string>(fmt::format("Couldn't flush file '{}'!", path.string()));
+#ifdef _WIN32
+    const auto sync_result = _commit(file.handle());
+#else
+    const auto sync_result = fsync(file.handle());
+#endif
+    if (sync_result != 0)
+        return tl::unexpected<std::string>(fmt::format("Couldn't sync file '{}' to disk!", path.string()));
+    return {};
+}
+
+template <tile_types::NamedTile T>
+tl::expected<void, std::string> Cache<T>::save_file(const std::filesystem::path& path, const std::vector<char>& bytes)
+{
+    QSaveFile file(QString::fromStdString(path.string()));
+    if (!file.open(QIODeviceBase::WriteOnly))
+        return tl::unexpected<std::string>(fmt::format("Couldn't open file '{}' for writing!", path.string()));
+    file.write(bytes.data(), qint64(bytes.size()));
+    if (!file.commit())
+        return tl::unexpected<std::string>(fmt::format("Couldn't write file '{}'!", path.string()));
+    return {};
+}
+
+template <tile_types::NamedTile T>
+template <typename Archive>
+tl::expected<void, std::string> Cache<T>::write_header(Archive* out, uint64_t generation)
+{
+    const VersionInformation version = T::version_information;
+    const auto r = (*out)(pack_format_version, version, generation);
+    if (failure(r))
+        return tl::unexpected(std::make_error_code(r).message());
+    return {};
+}
+
+template <tile_types::NamedTile T>
+template <typename Archive>
+tl::expected<uint64_t, std::string> Cache<T>::check_header(Archive* in, const std::filesystem::path& path)
+{
+    VersionInformation format_info = {};
+    VersionInformation version_info = {};
+    uint64_t generation = 0;
+    {
+        const auto r = (*in)(format_info, version_info, generation);
+        if (failure(r))
+            return tl::unexpected(std::make_error_code(r).message());
+    }
+    if (format_info != pack_format_version)
+        return tl::unexpected(fmt::format("Cache file '{}' is not a tile pack of the expected format!", path.string()));
+
+    if (version_info != T::version_information) {
+        version_info[version_info.size() - 1] = 0; // make sure that the string is 0 terminated.
+
+        return tl::unexpected(fmt::format("Cache file '{}' has incompatible version! Disk "
+                                          "version is '{}', but we expected '{}'.",
+            path.string(),
+            version_info.data(),
+            T::version_information.data()));
+    }
+    return generation;
+}
+
+template <tile_types::NamedTile T>
+void Cache<T>::invalidate_disk_state()
+{
+    // forces a complete rewrite on the next write
+    m_disk_cached.clear();
+    m_disk_generation = 0;
+    m_disk_pack_size = 0;
+    m_disk_live_bytes = 0;
+    m_disk_journal_size = 0;
+    m_disk_journal_records = 0;
 }
 
 template <tile_types::NamedTile T>
@@ -140,227 +608,462 @@ tl::expected<void, std::string> Cache<T>::write_to_disk(const std::filesystem::p
 {
     static_assert(tile_types::SerialisableTile<T>);
     std::filesystem::create_directories(base_path);
-    std::unordered_map<tile::Id, CacheObject, tile::Id::Hasher> data;
-    {
-        auto locker = std::scoped_lock(m_data_mutex);
-        data = m_data; // copies only metadata and references to tiles
-    }
     auto locker = std::scoped_lock(m_disk_cached_mutex);
 
-    const auto write = [](const auto& bytes, const auto& path) -> tl::expected<void, std::string> {
-        QFile file(path);
-        const auto success = file.open(QIODeviceBase::WriteOnly);
-        if (!success)
-            return tl::unexpected<std::string>(
-                fmt::format("Couldn't open file '{}' for writing!", path.string()));
-        file.write(bytes.data(), qint64(bytes.size()));
-        return {};
+    const auto file_matches = [](const std::filesystem::path& path, uint64_t expected_size) {
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(path, ec);
+        return !ec && size == expected_size;
     };
+    const bool journal_intact = m_disk_journal_size > 0 && file_matches(journal_path(base_path), m_disk_journal_size)
+        && file_matches(pack_path(base_path, m_disk_generation), m_disk_pack_size);
 
-    std::unordered_map<tile::Id, MetaData, tile::Id::Hasher> disk_cached_old;
-    std::swap(m_disk_cached, disk_cached_old);
-    m_disk_cached.reserve(data.size());
+    const auto r = journal_intact ? append_to_disk(base_path) : rewrite_disk(base_path);
+    if (!r.has_value())
+        invalidate_disk_state();
+    return r;
+}
 
-    // removing disk cache items, that were removed or updated in ram
-    for (const auto& item : disk_cached_old) {
-        const tile::Id& id = item.first;
-        const MetaData& meta = item.second;
-        if (data.contains(id) && data.at(id).meta.created == meta.created) {
-            continue;
-        }
-        std::filesystem::remove(tile_path(base_path, id));
+template <tile_types::NamedTile T>
+tl::expected<void, std::string> Cache<T>::append_to_disk(const std::filesystem::path& base_path)
+{
+    std::vector<std::pair<tile::Id, CacheObject>> dirty;
+    std::vector<tile::Id> evicted;
+    for (Shard& shard : m_shards) {
+        auto locker = std::scoped_lock(shard.mutex);
+        for (const auto& id : shard.dirty)
+            dirty.emplace_back(id, shard.data.at(id)); // copies only metadata and references to tiles. dirty tiles are never paged out.
+        evicted.insert(evicted.end(), shard.evicted.cbegin(), shard.evicted.cend());
+        shard.dirty.clear();
+        shard.evicted.clear();
     }
 
-        // write new or updated items to disk
-        for (const auto& item : data) {
-            const tile::Id& id = item.first;
-            const CacheObject& cache_object = item.second;
-            m_disk_cached[id] = cache_object.meta;
+    // tiles that were removed or updated leave garbage in the pack, and the journal grows with every change.
+    // both are rewritten once the garbage outweighs the live data.
+    uint64_t freed_bytes = 0;
+    const auto add_freed = [&](const tile::Id& id) {
+        const auto entry = m_disk_cached.find(id);
+        if (entry != m_disk_cached.end())
+            freed_bytes += entry->second.location.size;
+    };
+    std::for_each(evicted.cbegin(), evicted.cend(), add_freed);
+    std::for_each(dirty.cbegin(), dirty.cend(), [&](const auto& item) { add_freed(item.first); });
+    const auto garbage_bytes = m_disk_pack_size - m_disk_live_bytes + freed_bytes;
+    const auto n_journal_records = m_disk_journal_records + dirty.size() + evicted.size();
+    if (garbage_bytes > m_disk_live_bytes - freed_bytes || n_journal_records > 2 * m_disk_cached.size() + 1024)
+        return rewrite_disk(base_path);
 
-            if (disk_cached_old.contains(id) && disk_cached_old.at(id).created == cache_object.meta.created)
-                continue;
+    std::vector<char> pack_bytes;
+    zpp::bits::out pack_out(pack_bytes);
+    std::vector<char> journal_bytes;
+    zpp::bits::out journal_out(journal_bytes);
 
-            std::vector<char> bytes;
-            zpp::bits::out out(bytes);
-            const std::remove_cvref_t<decltype(T::version_information)> version = T::version_information;
-            {
-                const auto r = out(version);
-                if (failure(r))
-                    return tl::unexpected(std::make_error_code(r).message());
-            }
-            {
-                const auto r = out(cache_object.data);
-                if (failure(r))
-                    return tl::unexpected(std::make_error_code(r).message());
-            }
-            {
-                const auto r = write(bytes, tile_path(base_path, id));
-                if (!r.has_value())
-                    return r;
-            }
-        }
+    for (const auto& id : evicted) {
+        const auto entry = m_disk_cached.find(id);
+        if (entry == m_disk_cached.end())
+            continue;
+        m_disk_live_bytes -= entry->second.location.size;
+        m_disk_cached.erase(entry);
+        const auto r = journal_out(JournalRecord { JournalOperation::Erase, id, {}, {} });
+        if (failure(r))
+            return tl::unexpected(std::make_error_code(r).message());
+        ++m_disk_journal_records;
+    }
 
-        std::vector<char> bytes;
-        zpp::bits::out out(bytes);
-        const std::remove_cvref_t<decltype(T::version_information)> version = T::version_information;
+    for (const auto& item : dirty) {
+        const tile::Id& id = item.first;
+        const CacheObject& cache_object = item.second;
+        const auto position = pack_out.position();
         {
-            const auto r = out(version);
+            const auto r = pack_out(cache_object.data);
             if (failure(r))
                 return tl::unexpected(std::make_error_code(r).message());
         }
-
+        const auto location = DiskLocation { m_disk_pack_size + position, uint64_t(pack_out.position() - position) };
+        if (const auto entry = m_disk_cached.find(id); entry != m_disk_cached.end())
+            m_disk_live_bytes -= entry->second.location.size;
+        m_disk_cached[id] = { cache_object.meta(), location };
+        m_disk_live_bytes += location.size;
         {
-            const auto r = out(m_disk_cached);
+            const auto r = journal_out(JournalRecord { JournalOperation::Put, id, cache_object.meta(), location });
             if (failure(r))
                 return tl::unexpected(std::make_error_code(r).message());
         }
+        ++m_disk_journal_records;
+    }
 
-        const auto r = write(bytes, meta_info_path(base_path));
+    // the pack is written first. should writing the journal fail, the new pack data is never referenced.
+    {
+        const auto r = append_file(pack_path(base_path, m_disk_generation), pack_bytes);
         if (!r.has_value())
             return r;
-
-        return {};
+        m_disk_pack_size += pack_bytes.size();
+    }
+    {
+        const auto r = append_file(journal_path(base_path), journal_bytes);
+        if (!r.has_value())
+            return r;
+        m_disk_journal_size += journal_bytes.size();
+    }
+    return {};
 }
 
 template <tile_types::NamedTile T>
-tl::expected<void, std::string> Cache<T>::read_from_disk(const std::filesystem::path& base_path)
+tl::expected<void, std::string> Cache<T>::rewrite_disk(const std::filesystem::path& base_path)
 {
-    auto locker = std::scoped_lock(m_data_mutex, m_disk_cached_mutex);
-    assert(tile_types::SerialisableTile<T>);
-    const auto check_version = [](auto* in, const auto& path) -> tl::expected<void, std::string> {
-        std::remove_cvref_t<decltype(T::version_information)> version_info = {};
-        {
-            const auto r = (*in)(version_info);
+    std::vector<std::pair<tile::Id, CacheObject>> data;
+    std::shared_ptr<QFile> old_pack_file;
+    std::span<const uchar> old_pack_mapping;
+    {
+        // exclusive locks, as nothing may be paged in while objects are copied.
+        const auto locks = lock_all_shards<UniqueLocks>();
+        auto pack_locker = std::scoped_lock(m_pack_mutex);
+        for (Shard& shard : m_shards) {
+            data.insert(data.end(), shard.data.cbegin(), shard.data.cend()); // copies only metadata and references to tiles
+            shard.dirty.clear();
+            shard.evicted.clear();
+        }
+        old_pack_file = m_pack_file; // keeps the mapping alive for tiles that are not paged in
+        old_pack_mapping = m_pack_mapping;
+    }
+    // pack and journal carry the same generation, a journal is never replayed against a pack it wasn't written for.
+    const auto generation = std::max(utils::time_since_epoch(), m_disk_generation + 1);
+    invalidate_disk_state();
+
+    // the pack is streamed into the file. tiles that were never paged in are copied over from the old pack without deserialising them.
+    const auto path = pack_path(base_path, generation);
+    QSaveFile pack_file(QString::fromStdString(path.string()));
+    if (!pack_file.open(QIODeviceBase::WriteOnly))
+        return tl::unexpected<std::string>(fmt::format("Couldn't open file '{}' for writing!", path.string()));
+
+    std::vector<char> bytes;
+    {
+        zpp::bits::out out(bytes);
+        const auto r = write_header(&out, generation);
+        if (!r.has_value())
+            return r;
+    }
+    pack_file.write(bytes.data(), qint64(bytes.size()));
+    uint64_t pack_size = bytes.size();
+
+    std::vector<char> journal_bytes;
+    zpp::bits::out journal_out(journal_bytes);
+    {
+        const auto r = write_header(&journal_out, generation);
+        if (!r.has_value())
+            return r;
+    }
+
+    DiskIndex index;
+    index.reserve(data.size());
+    uint64_t live_bytes = 0;
+    for (const auto& item : data) {
+        const tile::Id& id = item.first;
+        const CacheObject& cache_object = item.second;
+        DiskLocation location = { pack_size, 0 };
+        if (cache_object.paged_out.load()) {
+            const DiskLocation source = cache_object.disk_location;
+            if (source.offset + source.size > old_pack_mapping.size())
+                return tl::unexpected<std::string>(fmt::format("Cache doesn't match the pack file that is mapped for '{}'!", base_path.string()));
+            pack_file.write(reinterpret_cast<const char*>(old_pack_mapping.data() + source.offset), qint64(source.size));
+            location.size = source.size;
+        } else {
+            bytes.clear();
+            zpp::bits::out out(bytes);
+            const auto r = out(cache_object.data);
             if (failure(r))
                 return tl::unexpected(std::make_error_code(r).message());
+            pack_file.write(bytes.data(), qint64(bytes.size()));
+            location.size = bytes.size();
         }
-        if (version_info != T::version_information) {
-            version_info[version_info.size() - 1] = 0;  // make sure that the string is 0 terminated.
-
-            return tl::unexpected(fmt::format("Cache file '{}' has incompatible version! Disk "
-                                              "version is '{}', but we expected '{}'.",
-                path.string(),
-                version_info.data(),
-                T::version_information.data()));
+        pack_size += location.size;
+        index[id] = { cache_object.meta(), location };
+        live_bytes += location.size;
+        const auto r = journal_out(JournalRecord { JournalOperation::Put, id, cache_object.meta(), location });
+        if (failure(r))
+            return tl::unexpected(std::make_error_code(r).message());
+    }
+
+    if (!pack_file.commit())
+        return tl::unexpected<std::string>(fmt::format("Couldn't write file '{}'!", path.string()));
+    {
+        const auto r = save_file(journal_path(base_path), journal_bytes);
+        if (!r.has_value())
+            return r;
+    }
+
+    auto new_pack_file = std::make_shared<QFile>(path);
+    const auto* new_pack_memory = new_pack_file->open(QIODeviceBase::ReadOnly) ? new_pack_file->map(0, new_pack_file->size()) : nullptr;
+    if (new_pack_memory == nullptr)
+        return tl::unexpected<std::string>(fmt::format("Couldn't map file '{}' into memory!", path.string()));
+    {
+        // disk locations are only read while holding the pack mutex.
+        const auto locks = lock_all_shards<SharedLocks>();
+        auto pack_locker = std::scoped_lock(m_pack_mutex);
+        for (const Shard& shard : m_shards) {
+            for (auto& entry : shard.data) {
+                // tiles that were paged in, replaced or erased in the meantime don't need the pack.
+                if (!entry.second.paged_out.load())
+                    continue;
+                const auto index_entry = index.find(entry.first);
+                if (index_entry != index.end())
+                    entry.second.disk_location = index_entry->second.location;
+            }
         }
-        return {};
+        m_pack_file = new_pack_file;
+        m_pack_mapping = std::span<const uchar>(new_pack_memory, size_t(new_pack_file->size()));
+    }
+    old_pack_mapping = {};
+    old_pack_file.reset();
+
+    // remove old generations (also the ones left behind by a crash).
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(base_path, ec)) {
+        if (entry.path().extension() == ".alp_pack" && entry.path() != path)
+            std::filesystem::remove(entry.path(), ec);
+    }
+
+    m_disk_journal_records = index.size();
+    m_disk_cached = std::move(index);
+    m_disk_generation = generation;
+    m_disk_pack_size = pack_size;
+    m_disk_live_bytes = live_bytes;
+    m_disk_journal_size = journal_bytes.size();
+    return {};
+}
+
+template <tile_types::NamedTile T>
+tl::expected<void, std::string> Cache<T>::read_from_disk(const std::filesystem::path& base_path)
+{
+    auto locker = std::scoped_lock(m_disk_cached_mutex);
+    const auto locks = lock_all_shards<UniqueLocks>();
+    auto pack_locker = std::scoped_lock(m_pack_mutex);
+    static_assert(tile_types::SerialisableTile<T>);
+    const auto clean_up = [&]() {
+        invalidate_disk_state();
+        for (Shard& shard : m_shards) {
+            shard.data.clear();
+            shard.dirty.clear();
+            shard.evicted.clear();
+            shard.eviction_queue.clear();
+            shard.n_bytes = 0;
+            shard.n_stored_bytes = 0;
+        }
+        m_pack_mapping = {};
+        m_pack_file.reset();
     };
-    const auto read_all = [](const auto& path) -> tl::expected<QByteArray, std::string> {
-        QFile file(path);
-        const auto success = file.open(QIODeviceBase::ReadOnly);
-        if (!success)
+    // both files are mapped into memory, zpp::bits deserialises directly out of the mapping.
+    const auto map_file = [](QFile* file, const std::filesystem::path& path) -> tl::expected<std::span<const uchar>, std::string> {
+        if (!file->open(QIODeviceBase::ReadOnly))
             return tl::unexpected(fmt::format("Couldn't open file '{}' for reading!", path.string()));
-        return file.readAll();
-    };
-    const auto clean_up = [&]() {
-        m_disk_cached.clear();
-        m_data.clear();
+        const auto* memory = file->map(0, file->size());
+        if (memory == nullptr)
+            return tl::unexpected(fmt::format("Couldn't map file '{}' into memory!", path.string()));
+        return std::span<const uchar>(memory, size_t(file->size()));
     };
 
     clean_up();
+    uint64_t generation = 0;
     {
-        const auto path = meta_info_path(base_path);
-        const auto bytes = read_all(path);
-        if (!bytes.has_value()) {
-            clean_up();
+        const auto path = journal_path(base_path);
+        QFile file(path);
+        const auto bytes = map_file(&file, path);
+        if (!bytes.has_value())
             return tl::unexpected(bytes.error());
-        }
+
         zpp::bits::in in(bytes.value());
         {
-            const auto r = check_version(&in, path);
-            if (!r.has_value()) {
-                clean_up();
-                return r;
-            }
+            const auto r = check_header(&in, path);
+            if (!r.has_value())
+                return tl::unexpected(r.error());
+            generation = r.value();
         }
-        {
-            const auto r = in(m_disk_cached);
-            if (failure(r)) {
-                clean_up();
-                return tl::unexpected(std::make_error_code(r).message());
+        // replay the journal. a torn record at the end (e.g., after a crash) ends the replay, the next write rewrites the journal.
+        uint64_t valid_size = in.position();
+        while (in.position() < bytes->size()) {
+            JournalRecord record;
+            if (failure(in(record)))
+                break;
+            valid_size = in.position();
+            ++m_disk_journal_records;
+            switch (record.operation) {
+            case JournalOperation::Put:
+                m_disk_cached[record.id] = { record.meta, record.location };
+                break;
+            case JournalOperation::Erase:
+                m_disk_cached.erase(record.id);
+                break;
             }
         }
+        m_disk_journal_size = valid_size;
     }
 
-    for (const auto& entry : m_disk_cached) {
-        const tile::Id& id = entry.first;
-        const MetaData& meta = entry.second;
-
-        const auto path = tile_path(base_path, id);
-        const auto bytes = read_all(path);
-        if (!bytes.has_value()) {
+    const auto path = pack_path(base_path, generation);
+    auto pack_file = std::make_shared<QFile>(path);
+    const auto bytes = map_file(pack_file.get(), path);
+    if (!bytes.has_value()) {
+        clean_up();
+        return tl::unexpected(bytes.error());
+    }
+    {
+        zpp::bits::in in(bytes.value());
+        const auto r = check_header(&in, path);
+        if (!r.has_value()) {
             clean_up();
-            return tl::unexpected(bytes.error());
+            return tl::unexpected(r.error());
         }
-        zpp::bits::in in(bytes.value());
-        {
-            const auto r = check_version(&in, path);
-            if (!r.has_value()) {
-                clean_up();
-                return r;
-            }
+        if (r.value() != generation) {
+            clean_up();
+            return tl::unexpected(fmt::format("Cache file '{}' doesn't belong to the journal!", path.string()));
         }
+    }
+    m_disk_generation = generation;
+    m_disk_pack_size = bytes->size();
 
-        CacheObject d;
-        {
-            const auto r = in(d.data);
-            if (failure(r)) {
-                clean_up();
-                return tl::unexpected(std::make_error_code(r).message());
-            }
+    // only the index is read, tiles stay in the mapped pack until they are paged in.
+    for (const auto& entry : m_disk_cached) {
+        const DiskIndexEntry& disk_entry = entry.second;
+        if (disk_entry.location.offset + disk_entry.location.size > m_disk_pack_size) {
+            clean_up();
+            return tl::unexpected(fmt::format("Cache file '{}' contains an invalid tile location!", path.string()));
+        }
+        m_disk_live_bytes += disk_entry.location.size;
+        Shard& shard = shard_for(entry.first);
+        CacheObject& object = shard.data[entry.first];
+        object.visited.store(disk_entry.meta.visited);
+        object.created = disk_entry.meta.created;
+        object.data.id = entry.first;
+        object.disk_location = disk_entry.location;
+        object.paged_out.store(true);
+        shard.n_bytes += size_of(object);
+        shard.n_stored_bytes += stored_size_of(object);
+        shard.eviction_queue.push_back({ disk_entry.meta.visited, entry.first });
+    }
+    for (Shard& shard : m_shards)
+        std::make_heap(shard.eviction_queue.begin(), shard.eviction_queue.end(), later_visited);
+    for (Shard& shard : m_shards) {
+        for (auto& entry : shard.data) {
+            if (entry.first.zoom_level == 0)
+                continue;
+            // linking each object with its parent links the whole tree.
+            const auto parent_id = entry.first.parent();
+            CacheObject* parent = find(parent_id);
+            if (!parent)
+                continue;
+            parent->children[child_slot(parent_id, entry.first)] = &entry.second;
+            entry.second.parent = parent;
         }
-        d.meta = meta;
-        m_data[d.data.id] = d;
     }
+    m_pack_file = std::move(pack_file);
+    m_pack_mapping = bytes.value();
 
     return {};
 }
 
+template <tile_types::NamedTile T>
+void Cache<T>::remove_from_disk(const std::filesystem::path& base_path)
+{
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(base_path, ec)) {
+        if (entry.path().extension() == ".alp_pack")
+            std::filesystem::remove(entry.path(), ec);
+    }
+    std::filesystem::remove(journal_path(base_path), ec);
+}
+
 template <tile_types::NamedTile T>
 template <typename VisitorFunction>
 void Cache<T>::visit(const VisitorFunction& functor)
 {
-    auto locker = std::scoped_lock(m_data_mutex);
+    const auto locks = lock_all_shards<SharedLocks>();
     const auto visited = utils::time_since_epoch();
     static_assert(requires { { functor(T()) } -> utils::convertible_to<bool>; }, "VisitorFunction must accept a const NamedTile and return a bool.");
-    const auto root = tile::Id { 0, { 0, 0 } };
-    visit(root, functor, visited);
+    CacheObject* root = find(tile::Id { 0, { 0, 0 } });
+    if (root)
+        visit(root, functor, visited);
 }
 
 template <tile_types::NamedTile T>
 template <typename VisitorFunction>
-void Cache<T>::visit(const tile::Id& node, const VisitorFunction& functor, uint64_t visited_stamp)
+void Cache<T>::visit_subtree(const tile::Id& root, const VisitorFunction& functor)
+{
+    const auto locks = lock_all_shards<SharedLocks>();
+    const auto visited = utils::time_since_epoch();
+    static_assert(requires { { functor(T()) } -> utils::convertible_to<bool>; }, "VisitorFunction must accept a const NamedTile and return a bool.");
+    CacheObject* node = find(root);
+    if (node)
+        visit(node, functor, visited);
+}
+
+template <tile_types::NamedTile T>
+template <typename VisitorFunction>
+void Cache<T>::visit(CacheObject* node, const VisitorFunction& functor, uint64_t visited_stamp)
 {
     static_assert(requires { { functor(T()) } -> utils::convertible_to<bool>; });
-    if (m_data.contains(node)) {
-        const auto should_continue = functor(m_data[node].data);
-        if (!should_continue)
-            return;
-        m_data[node].meta.visited = visited_stamp * 100 - m_data[node].data.id.zoom_level;
-        const auto children = node.children();
-        for (const auto& id : children) {
-            visit(id, functor, visited_stamp);
-        }
+    if (!page_in(node))
+        return; // broken on disk, treat it as missing.
+    const auto should_continue = functor(node->data);
+    if (!should_continue)
+        return;
+    node->visited.store(visited_stamp * 100 - node->data.id.zoom_level, std::memory_order_relaxed);
+    for (CacheObject* child : node->children) {
+        if (child)
+            visit(child, functor, visited_stamp);
     }
 }
 
 template<tile_types::NamedTile T>
-std::vector<T> Cache<T>::purge(unsigned remaining_capacity)
+std::vector<T> Cache<T>::purge(unsigned remaining_capacity, uint64_t remaining_bytes, uint64_t remaining_stored_bytes)
 {
-    auto locker = std::scoped_lock(m_data_mutex);
-    if (remaining_capacity >= m_data.size())
-        return {};
-    std::vector<std::pair<tile::Id, uint64_t>> tiles;
-    tiles.reserve(m_data.size());
-    std::transform(m_data.cbegin(), m_data.cend(), std::back_inserter(tiles), [](const auto& entry) { return std::make_pair(entry.first, entry.second.meta.visited); });
-    const auto nth_iter = tiles.begin() + remaining_capacity;
-    std::nth_element(tiles.begin(), nth_iter, tiles.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+    const auto locks = lock_all_shards<UniqueLocks>();
+    size_t n_objects = 0;
+    uint64_t n_bytes = 0;
+    uint64_t n_stored_bytes = 0;
+    for (const Shard& shard : m_shards) {
+        n_objects += shard.data.size();
+        n_bytes += shard.n_bytes.load();
+        n_stored_bytes += shard.n_stored_bytes.load();
+    }
+
+    // the work is proportional to the number of purged tiles plus the number of outdated entries, which are refreshed on the way.
     std::vector<T> purged_tiles;
-    purged_tiles.reserve(tiles.size() - remaining_capacity);
-    std::for_each(nth_iter, tiles.end(), [this, &purged_tiles](const auto& v) {
-        purged_tiles.push_back(m_data[v.first].data);
-        m_data.erase(v.first);
-    });
+    while (n_objects > remaining_capacity || n_bytes > remaining_bytes || n_stored_bytes > remaining_stored_bytes) {
+        Shard* oldest = nullptr;
+        for (Shard& shard : m_shards) {
+            if (!shard.eviction_queue.empty() && (!oldest || later_visited(oldest->eviction_queue.front(), shard.eviction_queue.front())))
+                oldest = &shard;
+        }
+        assert(oldest);
+        if (!oldest)
+            break;
+        std::pop_heap(oldest->eviction_queue.begin(), oldest->eviction_queue.end(), later_visited);
+        const EvictionEntry candidate = oldest->eviction_queue.back();
+        oldest->eviction_queue.pop_back();
+
+        const auto entry = oldest->data.find(candidate.id);
+        if (entry == oldest->data.end())
+            continue; // left behind by erase or a duplicate of an object that is already purged
+
+        const auto visited = entry->second.visited.load(std::memory_order_relaxed);
+        if (visited != candidate.visited) {
+            oldest->eviction_queue.push_back({ visited, candidate.id });
+            std::push_heap(oldest->eviction_queue.begin(), oldest->eviction_queue.end(), later_visited);
+            continue;
+        }
+
+        const auto size = size_of(entry->second);
+        oldest->n_bytes -= size;
+        n_bytes -= size;
+        const auto stored_size = stored_size_of(entry->second);
+        oldest->n_stored_bytes -= stored_size;
+        n_stored_bytes -= stored_size;
+        --n_objects;
+        unlink(&entry->second);
+        purged_tiles.push_back(std::move(entry->second.data));
+        oldest->data.erase(entry);
+        oldest->dirty.erase(candidate.id);
+        oldest->evicted.insert(candidate.id);
+    }
     return purged_tiles;
 }
 
@@ -0,0 +1,53 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "DirectoryTileSource.h"
+
+#include <QFile>
+
+using namespace nucleus::tile_scheduler;
+
+DirectoryTileSource::DirectoryTileSource(const QString& directory, UrlPattern url_pattern, const QString& file_ending, unsigned n_threads)
+    : LocalTileSource { n_threads }
+    , m_directory(directory.endsWith('/') ? directory : directory + '/')
+    , m_url_pattern(url_pattern)
+    , m_file_ending(file_ending)
+{
+}
+
+DirectoryTileSource::~DirectoryTileSource()
+{
+    stop_reading();
+}
+
+QString DirectoryTileSource::build_tile_path(const tile::Id& tile_id) const
+{
+    return m_directory + tile_address(tile_id, m_url_pattern) + m_file_ending;
+}
+
+tile_types::TileLayer DirectoryTileSource::read(const tile::Id& tile_id) const
+{
+    using Status = tile_types::NetworkInfo::Status;
+    QFile file(build_tile_path(tile_id));
+    const auto timestamp = utils::time_since_epoch();
+    if (!file.exists())
+        return { tile_id, { Status::NotFound, timestamp }, std::make_shared<QByteArray>() };
+    if (!file.open(QIODeviceBase::ReadOnly))
+        return { tile_id, { Status::NetworkError, timestamp }, std::make_shared<QByteArray>() };
+    return { tile_id, { Status::Good, timestamp }, std::make_shared<QByteArray>(file.readAll()) };
+}
@@ -0,0 +1,41 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include "LocalTileSource.h"
+
+namespace nucleus::tile_scheduler {
+
+// reads tiles from a directory tree, e.g., <directory>/12/2208/1365.png
+class DirectoryTileSource : public LocalTileSource {
+    Q_OBJECT
+public:
+    DirectoryTileSource(const QString& directory, UrlPattern url_pattern, const QString& file_ending, unsigned n_threads = 4);
+    ~DirectoryTileSource() override;
+    [[nodiscard]] QString build_tile_path(const tile::Id& tile_id) const;
+
+protected:
+    [[nodiscard]] tile_types::TileLayer read(const tile::Id& tile_id) const override;
+
+private:
+    QString m_directory;
+    UrlPattern m_url_pattern;
+    QString m_file_ending;
+};
+}
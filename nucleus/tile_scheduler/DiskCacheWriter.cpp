@@ -0,0 +1,84 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "DiskCacheWriter.h"
+
+#include <chrono>
+
+#include <QDebug>
+
+using namespace nucleus::tile_scheduler;
+
+DiskCacheWriter::DiskCacheWriter(MemoryCache* cache, const std::filesystem::path& path, QObject* parent)
+    : QObject { parent }
+    , m_cache(cache)
+    , m_path(path)
+{
+}
+
+void DiskCacheWriter::set_decoded_cache(Cache<tile_types::GpuTileQuad>* cache, const std::filesystem::path& path)
+{
+    m_decoded_cache = cache;
+    m_decoded_path = path;
+}
+
+void DiskCacheWriter::set_availability_path(const std::filesystem::path& path)
+{
+    m_availability_path = path;
+}
+
+void DiskCacheWriter::write(const std::optional<TileAvailability>& availability)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const auto r = m_cache->write_to_disk(m_path);
+    const auto diff = std::chrono::steady_clock::now() - start;
+
+    if (diff > std::chrono::milliseconds(50))
+        qDebug() << QString("DiskCacheWriter::write took %1ms for %2 quads.")
+                        .arg(std::chrono::duration_cast<std::chrono::milliseconds>(diff).count())
+                        .arg(m_cache->n_cached_objects());
+
+    if (!r.has_value()) {
+        qDebug() << QString("Writing tiles to disk into %1 failed: %2. Removing the tile pack.")
+                        .arg(QString::fromStdString(m_path.string()))
+                        .arg(QString::fromStdString(r.error()));
+        // the directory holds the decoded quads and the tile availability as well, they are fine.
+        MemoryCache::remove_from_disk(m_path);
+    }
+
+    // decoded quads are only an accelerator, failing to write them doesn't fail the whole write.
+    if (m_decoded_cache) {
+        const auto decoded_r = m_decoded_cache->write_to_disk(m_decoded_path);
+        if (!decoded_r.has_value()) {
+            qDebug() << QString("Writing decoded tiles to disk into %1 failed: %2. Removing the decoded tile pack.")
+                            .arg(QString::fromStdString(m_decoded_path.string()))
+                            .arg(QString::fromStdString(decoded_r.error()));
+            Cache<tile_types::GpuTileQuad>::remove_from_disk(m_decoded_path);
+        }
+    }
+
+    bool availability_written = false;
+    if (availability) {
+        assert(!m_availability_path.empty());
+        const auto availability_r = availability->write_to_disk(m_availability_path);
+        if (!availability_r.has_value())
+            qDebug() << QString("Writing tile availability failed: %1").arg(QString::fromStdString(availability_r.error()));
+        availability_written = availability_r.has_value();
+    }
+    emit write_finished(r.has_value(), availability_written);
+}
@@ -0,0 +1,56 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include <filesystem>
+#include <optional>
+
+#include <QObject>
+
+#include "Cache.h"
+#include "TileAvailability.h"
+
+namespace nucleus::tile_scheduler {
+
+/// Writes the ram cache, and optionally the cache of decoded quads and a snapshot of the tile availability, to disk. It is meant to live on its own thread, so that the scheduler never waits for the file system.
+/// The cache takes a snapshot of the changed tiles under its lock (payloads are shared, not copied) and writes without holding it.
+class DiskCacheWriter : public QObject {
+    Q_OBJECT
+public:
+    explicit DiskCacheWriter(MemoryCache* cache, const std::filesystem::path& path, QObject* parent = nullptr);
+    /// nullptr disables writing decoded quads. must be called on the writer's thread.
+    void set_decoded_cache(Cache<tile_types::GpuTileQuad>* cache, const std::filesystem::path& path);
+    /// where availability snapshots passed to write go. must be called on the writer's thread.
+    void set_availability_path(const std::filesystem::path& path);
+
+public slots:
+    void write(const std::optional<TileAvailability>& availability = {});
+
+signals:
+    /// availability_written is false if no availability was passed, or if writing it failed.
+    void write_finished(bool success, bool availability_written);
+
+private:
+    MemoryCache* m_cache;
+    std::filesystem::path m_path;
+    Cache<tile_types::GpuTileQuad>* m_decoded_cache = nullptr;
+    std::filesystem::path m_decoded_path;
+    std::filesystem::path m_availability_path;
+};
+}
@@ -19,8 +19,7 @@
 
 #include "DrawListGenerator.h"
 
-#include "radix/iterator.h"
-#include "radix/quad_tree.h"
+#include <algorithm>
 
 using nucleus::tile_scheduler::DrawListGenerator;
 
@@ -34,11 +33,13 @@ DrawListGenerator::DrawListGenerator()
 void DrawListGenerator::set_permissible_screen_space_error(float new_permissible_screen_space_error)
 {
     m_permissible_screen_space_error = new_permissible_screen_space_error;
+    m_cut.reset();
 }
 
 void DrawListGenerator::set_aabb_decorator(const tile_scheduler::utils::AabbDecoratorPtr& new_aabb_decorator)
 {
     m_aabb_decorator = new_aabb_decorator;
+    m_cut.reset();
 }
 
 void DrawListGenerator::add_tile(const tile::Id& id)
@@ -49,26 +50,16 @@ void DrawListGenerator::add_tile(const tile::Id& id)
 void DrawListGenerator::remove_tile(const tile::Id& id)
 {
     m_available_tiles.erase(id);
+    if (id.zoom_level > 0)
+        m_cut.invalidate(id.parent());
 }
 
-DrawListGenerator::TileSet DrawListGenerator::generate_for(const nucleus::camera::Definition& camera) const
+DrawListGenerator::TileSet DrawListGenerator::generate_for(const nucleus::camera::Definition& camera)
 {
-    const auto tile_refine_functor
-        = tile_scheduler::utils::refineFunctor(camera,
-                                               m_aabb_decorator,
-                                               m_permissible_screen_space_error);
-    const auto draw_refine_functor = [&tile_refine_functor, this](const tile::Id &tile) {
-        bool all = true;
-        for (const auto &child : tile.children()) {
-            all = all && m_available_tiles.contains(child);
-        }
-        return all && tile_refine_functor(tile);
+    const auto all_children_available = [this](const tile::Id& tile) {
+        const auto children = tile.children();
+        return std::all_of(children.cbegin(), children.cend(), [this](const tile::Id& child) { return m_available_tiles.contains(child); });
     };
-
-    const auto all_leaves = quad_tree::onTheFlyTraverse(tile::Id { 0, { 0, 0 } }, draw_refine_functor, [](const tile::Id& v) { return v.children(); });
-
-    TileSet tileset;
-    tileset.reserve(all_leaves.size());
-    std::copy(all_leaves.begin(), all_leaves.end(), radix::unordered_inserter(tileset));
-    return tileset;
+    m_cut.update(camera, m_aabb_decorator, m_permissible_screen_space_error, 256, all_children_available);
+    return m_cut.leaves();
 }
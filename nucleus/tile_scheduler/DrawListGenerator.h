@@ -19,11 +19,13 @@
 
 #pragma once
 
+#include "QuadTreeCut.h"
 #include "nucleus/camera/Definition.h"
-#include "radix/iterator.h"
 #include "utils.h"
 
+#include <algorithm>
 #include <unordered_set>
+#include <vector>
 
 namespace nucleus::tile_scheduler {
 class DrawListGenerator
@@ -37,25 +39,30 @@ public:
     void set_aabb_decorator(const utils::AabbDecoratorPtr& new_aabb_decorator);
     void add_tile(const tile::Id& id);
     void remove_tile(const tile::Id& id);
-    [[nodiscard]] TileSet generate_for(const camera::Definition& camera) const;
+    /// the cut is kept from one call to the next, so consecutive cameras should be similar (e.g., frames of an animation).
+    [[nodiscard]] TileSet generate_for(const camera::Definition& camera);
 
     template<class TileIdContainerType>
     TileSet cull(const TileIdContainerType& tileset, const camera::Frustum& frustum) const
     {
-        TileSet visible_leaves;
-        visible_leaves.reserve(tileset.size());
-
-        const auto is_visible = [frustum, this](const tile::Id& tile) {
-            return tile_scheduler::utils::camera_frustum_contains_tile(frustum, m_aabb_decorator->aabb(tile));
-        };
+        const std::vector<tile::Id> tiles(tileset.begin(), tileset.end());
+        std::vector<tile::SrsAndHeightBounds> aabbs(tiles.size());
+        std::transform(tiles.cbegin(), tiles.cend(), aabbs.begin(), [this](const tile::Id& tile) { return m_aabb_decorator->aabb(tile); });
+        const auto visible = tile_scheduler::utils::FrustumCuller(frustum).contains(aabbs);
 
-        std::copy_if(tileset.begin(), tileset.end(), radix::unordered_inserter(visible_leaves), is_visible);
+        TileSet visible_leaves;
+        visible_leaves.reserve(tiles.size());
+        for (size_t i = 0; i < tiles.size(); ++i) {
+            if (visible[i])
+                visible_leaves.insert(tiles[i]);
+        }
         return visible_leaves;
     }
 
 private:
     utils::AabbDecoratorPtr m_aabb_decorator;
     TileSet m_available_tiles;
+    QuadTreeCut m_cut;
     float m_permissible_screen_space_error = 2.0;
 };
 }
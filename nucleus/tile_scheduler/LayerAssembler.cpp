@@ -40,17 +40,46 @@ tile_types::LayeredTile LayerAssembler::join(const tile_types::TileLayer& ortho_
         return std::make_shared<QByteArray>();
     };
 
+    const auto validators_filter = [&network_info](const tile_types::CacheValidators& v) {
+        if (network_info.status == tile_types::NetworkInfo::Status::Good)
+            return v;
+        return tile_types::CacheValidators {};
+    };
+
     return {ortho_tile.id,
             network_info,
             data_filter(ortho_tile.data),
-            data_filter(height_tile.data)};
+            data_filter(height_tile.data),
+            validators_filter(ortho_tile.validators),
+            validators_filter(height_tile.validators)};
 }
 
 void LayerAssembler::load(const tile::Id& tile_id)
 {
+    if (const auto iter = m_validators.find(tile_id); iter != m_validators.end()) {
+        if (!iter->second.ortho.empty())
+            emit ortho_validators_announced(tile_id, iter->second.ortho);
+        if (!iter->second.height.empty())
+            emit height_validators_announced(tile_id, iter->second.height);
+        m_validators.erase(iter);
+    }
     emit tile_requested(tile_id);
 }
 
+void LayerAssembler::revalidate(const std::vector<tile_types::TileValidators>& validators)
+{
+    m_validators.clear();
+    for (const auto& v : validators)
+        m_validators[v.id] = v;
+}
+
+void LayerAssembler::cancel(const tile::Id& tile_id)
+{
+    m_ortho_data.erase(tile_id);
+    m_height_data.erase(tile_id);
+    emit tile_cancelled(tile_id);
+}
+
 void LayerAssembler::deliver_ortho(const tile_types::TileLayer& tile)
 {
     m_ortho_data[tile.id] = tile;
@@ -60,6 +89,9 @@ void LayerAssembler::deliver_ortho(const tile_types::TileLayer& tile)
 void LayerAssembler::deliver_height(const tile_types::TileLayer& tile)
 {
     m_height_data[tile.id] = tile;
+    // ortho photos are usually slower. the geometry can already be shown, with a placeholder texture.
+    if (!m_ortho_data.contains(tile.id) && tile.network_info.status == tile_types::NetworkInfo::Status::Good && tile.data && !tile.data->isEmpty())
+        emit preliminary_tile_loaded({ tile.id, tile.network_info, std::make_shared<QByteArray>(), tile.data, {}, {} });
     check_and_emit(tile.id);
 }
 
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <unordered_map>
+#include <vector>
 
 #include <QObject>
 
@@ -32,6 +33,8 @@ class LayerAssembler : public QObject {
 
     TileId2DataMap m_ortho_data;
     TileId2DataMap m_height_data;
+    // of the expired tiles in the last request list, announced to the sources right before they are requested.
+    std::unordered_map<tile::Id, tile_types::TileValidators, tile::Id::Hasher> m_validators;
 
 public:
     explicit LayerAssembler(QObject* parent = nullptr);
@@ -40,12 +43,21 @@ public:
 
 public slots:
     void load(const tile::Id& tile_id);
+    void cancel(const tile::Id& tile_id);
+    /// validators of the expired tiles in the request list, replacing the previous ones. they are split into their layers and announced
+    /// to the tile sources right before the tiles are requested, so that the sources don't keep validators of tiles that are never loaded.
+    void revalidate(const std::vector<tile_types::TileValidators>& validators);
     void deliver_ortho(const tile_types::TileLayer& tile);
     void deliver_height(const tile_types::TileLayer& tile);
 
 signals:
     void tile_requested(const tile::Id& tile_id);
+    void tile_cancelled(const tile::Id& tile_id);
+    void ortho_validators_announced(const tile::Id& tile_id, const tile_types::CacheValidators& validators);
+    void height_validators_announced(const tile::Id& tile_id, const tile_types::CacheValidators& validators);
     void tile_loaded(const tile_types::LayeredTile& tile);
+    /// heights arrived before the ortho photo. the ortho is empty, tile_loaded follows once it is there.
+    void preliminary_tile_loaded(const tile_types::LayeredTile& tile);
 
 private:
     void check_and_emit(const tile::Id& tile_id);
@@ -0,0 +1,74 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "LocalTileSource.h"
+
+#include <algorithm>
+
+#include <QThreadPool>
+
+using namespace nucleus::tile_scheduler;
+
+LocalTileSource::LocalTileSource(unsigned n_threads)
+{
+#ifdef ALP_ENABLE_THREADING
+    m_read_pool = std::make_unique<QThreadPool>();
+    m_read_pool->setMaxThreadCount(int(std::max(1u, n_threads)));
+    m_read_pool->setExpiryTimeout(-1); // keep the threads, derived classes may hold per thread resources
+    m_read_pool->setObjectName("local_tile_source_read_pool");
+#else
+    Q_UNUSED(n_threads);
+#endif
+}
+
+LocalTileSource::~LocalTileSource() = default;
+
+void LocalTileSource::load(const tile::Id& tile_id)
+{
+    m_pending.insert(tile_id);
+    auto read_and_deliver = [this, tile_id]() {
+        const auto tile = read(tile_id);
+        // delivered on the thread of this object. posted events are dropped if it is gone.
+        QMetaObject::invokeMethod(this, [this, tile]() { deliver(tile); }, Qt::QueuedConnection);
+    };
+#ifdef ALP_ENABLE_THREADING
+    m_read_pool->start(read_and_deliver);
+#else
+    read_and_deliver();
+#endif
+}
+
+void LocalTileSource::cancel(const tile::Id& tile_id)
+{
+    m_pending.erase(tile_id);
+}
+
+void LocalTileSource::stop_reading()
+{
+#ifdef ALP_ENABLE_THREADING
+    m_read_pool->clear();
+    m_read_pool->waitForDone();
+#endif
+}
+
+void LocalTileSource::deliver(const tile_types::TileLayer& tile)
+{
+    if (m_pending.erase(tile.id) == 0)
+        return; // cancelled
+    emit load_finished(tile);
+}
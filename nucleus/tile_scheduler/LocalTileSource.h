@@ -0,0 +1,55 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <unordered_set>
+
+#include "TileSource.h"
+
+class QThreadPool;
+
+namespace nucleus::tile_scheduler {
+
+// base for sources that read from local storage. reads happen on a thread pool, so that the scheduler's event loop is not blocked.
+// derived classes must call stop_reading() in their destructor, as read() is virtual.
+class LocalTileSource : public TileSource {
+    Q_OBJECT
+public:
+    explicit LocalTileSource(unsigned n_threads);
+    ~LocalTileSource() override;
+
+public slots:
+    void load(const tile::Id& tile_id) override;
+    void cancel(const tile::Id& tile_id) override;
+
+protected:
+    /// called on one of the pool threads
+    [[nodiscard]] virtual tile_types::TileLayer read(const tile::Id& tile_id) const = 0;
+    void stop_reading();
+
+private:
+    void deliver(const tile_types::TileLayer& tile);
+
+    std::unordered_set<tile::Id, tile::Id::Hasher> m_pending;
+#ifdef ALP_ENABLE_THREADING
+    std::unique_ptr<QThreadPool> m_read_pool;
+#endif
+};
+}
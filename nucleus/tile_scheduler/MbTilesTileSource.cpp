@@ -0,0 +1,114 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "MbTilesTileSource.h"
+
+#include <memory>
+#include <unordered_map>
+
+#include <QDebug>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+
+using namespace nucleus::tile_scheduler;
+
+namespace {
+struct Connection {
+    QString name;
+    std::unique_ptr<QSqlQuery> query; // null if the database could not be opened
+};
+
+// the connections opened on this thread, one per source. they are closed when the thread finishes, i.e., on the thread itself.
+struct ThreadConnections {
+    std::unordered_map<const MbTilesTileSource*, Connection> connections;
+
+    void close(const MbTilesTileSource* source)
+    {
+        const auto iter = connections.find(source);
+        if (iter == connections.end())
+            return;
+        iter->second.query.reset(); // the query references the database, it must be gone before removing it
+        QSqlDatabase::removeDatabase(iter->second.name);
+        connections.erase(iter);
+    }
+    ~ThreadConnections()
+    {
+        while (!connections.empty())
+            close(connections.begin()->first);
+    }
+};
+thread_local ThreadConnections t_connections;
+} // namespace
+
+MbTilesTileSource::MbTilesTileSource(const QString& path, unsigned n_connections)
+    : LocalTileSource { n_connections }
+    , m_path(path)
+{
+}
+
+MbTilesTileSource::~MbTilesTileSource()
+{
+    stop_reading();
+    // without threading, reads happen on this thread. otherwise the pool threads close their connections when they finish.
+    t_connections.close(this);
+}
+
+QSqlQuery* MbTilesTileSource::query_for_current_thread() const
+{
+    auto iter = t_connections.connections.find(this);
+    if (iter != t_connections.connections.end())
+        return iter->second.query.get();
+
+    Connection& connection = t_connections.connections[this];
+    connection.name = QString("mbtiles_%1_%2").arg(quintptr(this)).arg(quintptr(QThread::currentThread()));
+    auto db = QSqlDatabase::addDatabase("QSQLITE", connection.name);
+    db.setDatabaseName(m_path);
+    db.setConnectOptions("QSQLITE_OPEN_READONLY");
+    if (!db.open()) {
+        qWarning() << "Could not open" << m_path << ":" << db.lastError().text();
+        return nullptr;
+    }
+    auto query = std::make_unique<QSqlQuery>(db);
+    if (!query->prepare("SELECT tile_data FROM tiles WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?")) {
+        qWarning() << "Could not prepare the tile query for" << m_path << ":" << query->lastError().text();
+        return nullptr;
+    }
+    connection.query = std::move(query);
+    return connection.query.get();
+}
+
+tile_types::TileLayer MbTilesTileSource::read(const tile::Id& tile_id) const
+{
+    using Status = tile_types::NetworkInfo::Status;
+    auto* query = query_for_current_thread();
+    const auto timestamp = utils::time_since_epoch();
+    if (!query)
+        return { tile_id, { Status::NetworkError, timestamp }, std::make_shared<QByteArray>() };
+
+    query->bindValue(0, tile_id.zoom_level);
+    query->bindValue(1, tile_id.coords.x);
+    query->bindValue(2, tile_id.coords.y);
+    if (!query->exec())
+        return { tile_id, { Status::NetworkError, timestamp }, std::make_shared<QByteArray>() };
+    const auto found = query->next();
+    auto data = std::make_shared<QByteArray>(found ? query->value(0).toByteArray() : QByteArray());
+    query->finish();
+    return { tile_id, { found ? Status::Good : Status::NotFound, timestamp }, std::move(data) };
+}
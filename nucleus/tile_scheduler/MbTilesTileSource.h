@@ -0,0 +1,45 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include "LocalTileSource.h"
+
+class QSqlQuery;
+
+namespace nucleus::tile_scheduler {
+
+// reads tiles from an mbtiles container (sqlite, https://github.com/mapbox/mbtiles-spec).
+// every pool thread gets its own read-only connection with a prepared query. qt sql connections may only be used and removed on the
+// thread that opened them, so they belong to that thread and are closed there, when the thread finishes (with the pool of this source).
+// mbtiles rows are numbered from the south (tms), which matches tile::Id.
+class MbTilesTileSource : public LocalTileSource {
+    Q_OBJECT
+public:
+    explicit MbTilesTileSource(const QString& path, unsigned n_connections = 4);
+    ~MbTilesTileSource() override;
+
+protected:
+    [[nodiscard]] tile_types::TileLayer read(const tile::Id& tile_id) const override;
+
+private:
+    QSqlQuery* query_for_current_thread() const; // null if the database could not be opened
+
+    QString m_path;
+};
+}
@@ -18,6 +18,8 @@
 
 #include "QuadAssembler.h"
 
+#include <algorithm>
+
 using namespace nucleus::tile_scheduler;
 
 QuadAssembler::QuadAssembler(QObject *parent)
@@ -38,12 +40,60 @@ void QuadAssembler::load(const tile::Id& tile_id)
     }
 }
 
+void QuadAssembler::cancel(const tile::Id& tile_id)
+{
+    m_preliminary_quads.erase(tile_id);
+    if (m_quads.erase(tile_id) == 0)
+        return;
+    for (const auto& child_id : tile_id.children()) {
+        emit tile_cancelled(child_id);
+    }
+}
+
 void QuadAssembler::deliver_tile(const tile_types::LayeredTile& tile)
 {
-    auto& quad = m_quads[tile.id.parent()];
+    const auto iter = m_quads.find(tile.id.parent());
+    if (iter == m_quads.end())
+        return; // cancelled
+    auto& quad = iter->second;
     quad.tiles[quad.n_tiles++] = tile;
     if (quad.n_tiles == 4) {
+        m_preliminary_quads.erase(quad.id);
         emit quad_loaded(quad);
         m_quads.erase(quad.id);
+        return;
+    }
+    emit_preliminary_if_covered(quad.id);
+}
+
+void QuadAssembler::deliver_preliminary_tile(const tile_types::LayeredTile& tile)
+{
+    const auto quad_id = tile.id.parent();
+    if (!m_quads.contains(quad_id))
+        return; // cancelled
+    auto& preliminary = m_preliminary_quads[quad_id];
+    preliminary.id = quad_id;
+    preliminary.tiles[preliminary.n_tiles++] = tile;
+    emit_preliminary_if_covered(quad_id);
+}
+
+void QuadAssembler::emit_preliminary_if_covered(const tile::Id& quad_id)
+{
+    const auto preliminary_iter = m_preliminary_quads.find(quad_id);
+    if (preliminary_iter == m_preliminary_quads.end())
+        return;
+    const auto& preliminary = preliminary_iter->second;
+    const auto& complete = m_quads.at(quad_id);
+    // complete tiles take precedence
+    auto quad = complete;
+    for (unsigned i = 0; i < preliminary.n_tiles; ++i) {
+        const auto& tile = preliminary.tiles[i];
+        const auto delivered = std::any_of(complete.tiles.cbegin(), complete.tiles.cbegin() + complete.n_tiles, [&tile](const auto& t) { return t.id == tile.id; });
+        if (!delivered)
+            quad.tiles[quad.n_tiles++] = tile;
     }
+    if (quad.n_tiles < 4)
+        return;
+    m_preliminary_quads.erase(preliminary_iter);
+    emit preliminary_quad_loaded(quad);
 }
@@ -32,6 +32,7 @@ class QuadAssembler : public QObject {
     using TileId2QuadMap = std::unordered_map<tile::Id, tile_types::TileQuad, tile::Id::Hasher>;
 
     TileId2QuadMap m_quads;
+    TileId2QuadMap m_preliminary_quads; // tiles that have heights, but no ortho yet
 
 public:
     explicit QuadAssembler(QObject* parent = nullptr);
@@ -39,11 +40,19 @@ public:
 
 public slots:
     void load(const tile::Id& tile_id);
+    void cancel(const tile::Id& tile_id);
     void deliver_tile(const tile_types::LayeredTile& tile);
+    void deliver_preliminary_tile(const tile_types::LayeredTile& tile);
 
 signals:
     void tile_requested(const tile::Id& tile_id);
+    void tile_cancelled(const tile::Id& tile_id);
     void quad_loaded(const tile_types::TileQuad& tile);
+    /// emitted once per quad, as soon as all children have at least their heights. quad_loaded follows.
+    void preliminary_quad_loaded(const tile_types::TileQuad& tile);
+
+private:
+    void emit_preliminary_if_covered(const tile::Id& quad_id);
 };
 
 }
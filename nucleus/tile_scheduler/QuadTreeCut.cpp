@@ -0,0 +1,173 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#include "QuadTreeCut.h"
+
+#include <cmath>
+#include <limits>
+
+namespace nucleus::tile_scheduler {
+
+void QuadTreeCut::update(const camera::Definition& camera, const utils::AabbDecoratorPtr& aabb_decorator, float error_threshold_px, double tile_size)
+{
+    update(camera, aabb_decorator, error_threshold_px, tile_size, [](const tile::Id&) { return true; });
+}
+
+void QuadTreeCut::invalidate(const tile::Id& id)
+{
+    const auto iter = m_decisions.find(id);
+    if (iter == m_decisions.end())
+        return;
+    iter->second = Decision { .refine = iter->second.refine };
+}
+
+void QuadTreeCut::reset()
+{
+    m_decisions.clear();
+    m_inner_nodes.clear();
+    m_leaves.clear();
+    m_last_camera.reset();
+}
+
+const QuadTreeCut::TileSet& QuadTreeCut::inner_nodes() const { return m_inner_nodes; }
+
+const QuadTreeCut::TileSet& QuadTreeCut::leaves() const { return m_leaves; }
+
+unsigned QuadTreeCut::n_evaluated() const { return m_n_evaluated; }
+
+void QuadTreeCut::begin_update(const camera::Definition& camera)
+{
+    m_n_evaluated = 0;
+    // the margins are only valid for the same frustum shape and screen space error scaling
+    if (m_last_camera
+        && (m_last_camera->field_of_view() != camera.field_of_view() || m_last_camera->viewport_size() != camera.viewport_size()
+            || m_last_camera->near_plane() != camera.near_plane() || m_last_camera->distance_scale_factor() != camera.distance_scale_factor()))
+        reset();
+
+    if (m_last_camera) {
+        m_travelled += glm::distance(m_last_camera->position(), camera.position());
+        const auto dx = camera.x_axis() - m_last_camera->x_axis();
+        const auto dy = camera.y_axis() - m_last_camera->y_axis();
+        const auto dz = camera.z_axis() - m_last_camera->z_axis();
+        m_turned += std::sqrt(glm::dot(dx, dx) + glm::dot(dy, dy) + glm::dot(dz, dz));
+    }
+    m_last_camera = camera;
+
+    if (m_decisions.empty()) {
+        const auto root = tile::Id { 0, { 0, 0 } };
+        m_decisions[root] = {};
+        m_leaves.insert(root);
+    }
+}
+
+QuadTreeCut::Decision QuadTreeCut::evaluate(const tile::Id& id,
+    const tile::SrsAndHeightBounds& aabb,
+    bool contained,
+    const camera::Definition& camera,
+    const camera::Frustum& frustum,
+    float error_threshold_px,
+    double tile_size) const
+{
+    constexpr auto infinity = std::numeric_limits<double>::infinity();
+    constexpr auto sqrt2 = 1.414213562373095;
+    // for rounding errors, in metres and relative to the threshold distance
+    constexpr auto slack = 0.001;
+    constexpr auto relative_slack = 0.0001;
+
+    Decision decision;
+    decision.travelled = m_travelled;
+    decision.turned = m_turned;
+    if (id.zoom_level >= 18) {
+        decision.frustum_margin = infinity;
+        decision.error_margin = infinity;
+        return decision;
+    }
+
+    // same decision as refineFunctor
+    const auto position = camera.position();
+    const auto distance = float(geometry::distance(aabb, position));
+    const auto pixel_size = float(sqrt2 * aabb.size().x / tile_size);
+    const auto error_above_threshold = camera.to_screen_space(pixel_size, distance) >= error_threshold_px;
+    decision.refine = contained && error_above_threshold;
+
+    // plane distances change at most by the camera movement plus the rotation times the distance of the point from the (moved) camera.
+    // a tile stays in the frustum as long as one of its points stays inside. candidates are the corners, the centre and the point
+    // closest to the view direction. it stays outside, as long as all corners stay outside of one plane.
+    const auto inside_by = [&frustum](const glm::dvec3& point) {
+        auto margin = infinity;
+        for (const auto& plane : frustum.clipping_planes)
+            margin = std::min(margin, geometry::distance(plane, point));
+        return margin;
+    };
+    const auto centre = (aabb.min + aabb.max) * 0.5;
+    auto contained_margin = std::max(inside_by(centre), inside_by(glm::clamp(position - camera.z_axis() * glm::distance(position, centre), aabb.min, aabb.max)));
+    for (unsigned i = 0; i < 8; ++i)
+        contained_margin = std::max(contained_margin, inside_by({ (i & 1u) ? aabb.max.x : aabb.min.x, (i & 2u) ? aabb.max.y : aabb.min.y, (i & 4u) ? aabb.max.z : aabb.min.z }));
+    auto outside_margin = 0.0;
+    for (const auto& plane : frustum.clipping_planes) {
+        const auto farthest_corner = glm::dvec3 { plane.normal.x > 0 ? aabb.max.x : aabb.min.x, plane.normal.y > 0 ? aabb.max.y : aabb.min.y, plane.normal.z > 0 ? aabb.max.z : aabb.min.z };
+        outside_margin = std::max(outside_margin, -geometry::distance(plane, farthest_corner));
+    }
+    decision.radius = glm::length(glm::max(glm::abs(aabb.min - position), glm::abs(aabb.max - position)));
+
+    // the distance to the tile changes at most by the camera movement
+    const auto threshold_distance = double(camera.to_screen_space(pixel_size, 1.f)) / double(error_threshold_px);
+    const auto error_margin = std::abs(double(distance) - threshold_distance) - relative_slack * threshold_distance - slack;
+
+    if (decision.refine) {
+        decision.frustum_margin = contained_margin - slack;
+        decision.error_margin = error_margin;
+    } else {
+        decision.frustum_margin = outside_margin - slack;
+        decision.error_margin = error_above_threshold ? 0.0 : error_margin;
+    }
+    decision.frustum_margin = std::max(decision.frustum_margin, 0.0);
+    decision.error_margin = std::max(decision.error_margin, 0.0);
+    return decision;
+}
+
+bool QuadTreeCut::still_valid(const Decision& decision) const
+{
+    const auto travelled = m_travelled - decision.travelled;
+    const auto turned = m_turned - decision.turned;
+    // the planes turn around the current camera position, which is up to radius + travelled away from the tile
+    const auto frustum_unchanged = travelled + turned * (decision.radius + travelled) <= decision.frustum_margin;
+    const auto error_unchanged = travelled <= decision.error_margin;
+    if (decision.refine)
+        return frustum_unchanged && error_unchanged;
+    return frustum_unchanged || error_unchanged;
+}
+
+void QuadTreeCut::collapse(const tile::Id& id)
+{
+    m_inner_nodes.erase(id);
+    m_leaves.insert(id);
+    for (const auto& child : id.children())
+        erase_subtree(child);
+}
+
+void QuadTreeCut::erase_subtree(const tile::Id& id)
+{
+    m_decisions.erase(id);
+    if (m_leaves.erase(id))
+        return;
+    m_inner_nodes.erase(id);
+    for (const auto& child : id.children())
+        erase_subtree(child);
+}
+
+} // namespace nucleus::tile_scheduler
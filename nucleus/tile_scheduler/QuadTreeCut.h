@@ -0,0 +1,153 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <radix/tile.h>
+
+#include "nucleus/camera/Definition.h"
+#include "utils.h"
+
+namespace nucleus::tile_scheduler {
+
+/// The cut through the quad tree that refineFunctor selects for a camera, kept from one camera update to the next.
+/// Every tile in the cut remembers how far the camera may move and turn before its refine decision could change: the distance to
+/// the frustum planes for tiles that are completely inside or outside, and the distance to the point where the screen space error
+/// crosses the threshold. Only tiles whose margin is used up are evaluated again, and split or collapsed if their decision changed.
+/// For the small camera changes of normal interaction, these are the tiles close to the frustum and refinement boundaries. The
+/// result is the same as the one of a full traversal.
+///
+/// The filter is asked for every evaluated tile, tiles that it rejects are evaluated again on every update. If it starts to reject
+/// a tile that it accepted before, call invalidate. Other changes to the selection (aabb decorator, error threshold) require a reset.
+class QuadTreeCut {
+public:
+    using TileSet = std::unordered_set<tile::Id, tile::Id::Hasher>;
+
+    template <typename Filter>
+    void update(const camera::Definition& camera, const utils::AabbDecoratorPtr& aabb_decorator, float error_threshold_px, double tile_size, const Filter& filter);
+    void update(const camera::Definition& camera, const utils::AabbDecoratorPtr& aabb_decorator, float error_threshold_px, double tile_size = 256);
+    /// the tile is evaluated again on the next update.
+    void invalidate(const tile::Id& id);
+    void reset();
+
+    [[nodiscard]] const TileSet& inner_nodes() const;
+    [[nodiscard]] const TileSet& leaves() const;
+    /// number of tiles that were evaluated during the last update.
+    [[nodiscard]] unsigned n_evaluated() const;
+
+private:
+    struct Decision {
+        bool refine = false;
+        // the decision holds while the frustum planes moved at most frustum_margin (for the points of the tile, which were at most
+        // radius away from the camera at the time of the decision, and at most radius plus the distance travelled since), or while
+        // the camera moved at most error_margin. a refined tile needs both.
+        // -infinity means that the decision must be made again.
+        double frustum_margin = -std::numeric_limits<double>::infinity();
+        double error_margin = -std::numeric_limits<double>::infinity();
+        double radius = 0;
+        // m_travelled and m_turned at the time of the decision
+        double travelled = 0;
+        double turned = 0;
+    };
+
+    void begin_update(const camera::Definition& camera);
+    /// contained is the result of camera_frustum_contains_tile for the aabb.
+    [[nodiscard]] Decision evaluate(const tile::Id& id, const tile::SrsAndHeightBounds& aabb, bool contained, const camera::Definition& camera, const camera::Frustum& frustum, float error_threshold_px, double tile_size) const;
+    [[nodiscard]] bool still_valid(const Decision& decision) const;
+    void collapse(const tile::Id& id);
+    void erase_subtree(const tile::Id& id);
+
+    std::unordered_map<tile::Id, Decision, tile::Id::Hasher> m_decisions; // for all tiles in the cut, inner nodes and leaves
+    TileSet m_inner_nodes;
+    TileSet m_leaves;
+    std::optional<camera::Definition> m_last_camera;
+    // upper bounds for the movement and rotation since any previous update. the rotation is the norm of the difference between
+    // the rotation matrices, which bounds how far any unit vector (e.g., a plane normal) turned.
+    double m_travelled = 0;
+    double m_turned = 0;
+    unsigned m_n_evaluated = 0;
+};
+
+template <typename Filter>
+void QuadTreeCut::update(const camera::Definition& camera, const utils::AabbDecoratorPtr& aabb_decorator, float error_threshold_px, double tile_size, const Filter& filter)
+{
+    static_assert(requires { { filter(tile::Id()) } -> utils::convertible_to<bool>; }, "Filter must accept a tile::Id and return a bool.");
+    begin_update(camera);
+    const auto frustum = camera.frustum();
+    const auto culler = utils::FrustumCuller(frustum);
+    const auto evaluate_tile = [&](const tile::Id& id, const tile::SrsAndHeightBounds& aabb, bool contained) {
+        ++m_n_evaluated;
+        if (!filter(id))
+            return Decision {};
+        return evaluate(id, aabb, contained, camera, frustum, error_threshold_px, tile_size);
+    };
+
+    std::vector<tile::Id> outdated;
+    for (const auto& [id, decision] : m_decisions) {
+        if (!still_valid(decision))
+            outdated.push_back(id);
+    }
+    // coarse first, so that outdated tiles below a collapsed one are dropped without evaluating them
+    std::sort(outdated.begin(), outdated.end(), [](const tile::Id& a, const tile::Id& b) { return a.zoom_level < b.zoom_level; });
+
+    std::vector<tile::Id> to_split;
+    for (const auto& id : outdated) {
+        const auto iter = m_decisions.find(id);
+        if (iter == m_decisions.end())
+            continue;
+        const auto aabb = aabb_decorator->aabb(id);
+        iter->second = evaluate_tile(id, aabb, culler.contains(aabb));
+        const auto is_inner_node = m_inner_nodes.contains(id);
+        if (is_inner_node && !iter->second.refine)
+            collapse(id);
+        else if (!is_inner_node && iter->second.refine)
+            to_split.push_back(id);
+    }
+
+    while (!to_split.empty()) {
+        const auto id = to_split.back();
+        to_split.pop_back();
+        m_leaves.erase(id);
+        m_inner_nodes.insert(id);
+        // the children are culled together
+        const auto children = id.children();
+        std::array<tile::SrsAndHeightBounds, utils::FrustumCuller::n_lanes> aabbs;
+        assert(children.size() == aabbs.size());
+        std::transform(children.cbegin(), children.cend(), aabbs.begin(), [&](const tile::Id& child) { return aabb_decorator->aabb(child); });
+        const auto contained = culler.contains(aabbs);
+        for (size_t i = 0; i < children.size(); ++i) {
+            const auto& child = children[i];
+            const auto decision = evaluate_tile(child, aabbs[i], contained[i]);
+            m_decisions[child] = decision;
+            if (decision.refine)
+                to_split.push_back(child);
+            else
+                m_leaves.insert(child);
+        }
+    }
+}
+
+}
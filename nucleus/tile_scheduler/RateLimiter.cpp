@@ -18,6 +18,8 @@
 
 #include "RateLimiter.h"
 
+#include <algorithm>
+
 #include <QTimer>
 
 #include "utils.h"
@@ -52,25 +54,103 @@ size_t RateLimiter::queue_size() const
     return m_request_queue.size();
 }
 
+void RateLimiter::set_adaptive(bool enabled)
+{
+    m_adaptive = enabled;
+    m_forwarded_at.clear();
+}
+
+bool RateLimiter::adaptive() const
+{
+    return m_adaptive;
+}
+
+void RateLimiter::set_adaptive_bounds(unsigned int min_rate, unsigned int max_rate)
+{
+    assert(min_rate > 0);
+    assert(min_rate <= max_rate);
+    m_min_rate = min_rate;
+    m_max_rate = max_rate;
+}
+
+std::pair<unsigned int, unsigned int> RateLimiter::adaptive_bounds() const
+{
+    return { m_min_rate, m_max_rate };
+}
+
+float RateLimiter::smoothed_latency() const
+{
+    return m_smoothed_latency;
+}
+
 void RateLimiter::request_quad(const tile::Id& id)
 {
     m_request_queue.push_back(id);
     process_request_queue();
 }
 
+void RateLimiter::cancel_quad(const tile::Id& id)
+{
+    const auto iter = std::find(m_request_queue.cbegin(), m_request_queue.cend(), id);
+    if (iter != m_request_queue.cend()) {
+        m_request_queue.erase(iter);
+        return;
+    }
+    m_forwarded_at.erase(id);
+    emit quad_cancelled(id);
+}
+
+void RateLimiter::receive_quad(const tile_types::TileQuad& quad)
+{
+    const auto iter = m_forwarded_at.find(quad.id);
+    if (iter == m_forwarded_at.end())
+        return;
+    const auto current_msecs = utils::time_since_epoch();
+    const auto latency = float(current_msecs - iter->second);
+    m_forwarded_at.erase(iter);
+
+    const auto failed = quad.network_info().status == tile_types::NetworkInfo::Status::NetworkError;
+    if (!failed) { // the latency of failures (e.g., timeouts) says nothing about the connection
+        // the baseline follows higher latencies very slowly, so that it recovers from outliers (e.g., http cache hits) and route changes
+        m_base_latency = (latency < m_base_latency) ? latency : m_base_latency + (latency - m_base_latency) * 0.001f;
+        m_smoothed_latency = (m_smoothed_latency < 0) ? latency : m_smoothed_latency * 0.875f + latency * 0.125f; // same gain as tcp's srtt
+    }
+    // rising means double the baseline, with some slack for fast connections
+    const auto latency_rising = m_smoothed_latency > 2 * m_base_latency + 50;
+    const auto congested = failed || latency_rising;
+
+    // at most one change per period, the responses to one change take that long to come in
+    if (current_msecs - m_last_rate_change < m_rate_period_msecs)
+        return;
+    if (congested)
+        change_rate(std::max(m_min_rate, unsigned(float(m_rate) * m_multiplicative_decrease)), current_msecs);
+    else if (!m_request_queue.empty()) // only grow if the rate is the bottleneck
+        change_rate(std::min(m_max_rate, m_rate + m_additive_increase), current_msecs);
+}
+
+void RateLimiter::change_rate(unsigned int new_rate, uint64_t current_msecs)
+{
+    m_last_rate_change = current_msecs;
+    if (new_rate == m_rate)
+        return;
+    m_rate = new_rate;
+    emit rate_changed(m_rate);
+    process_request_queue();
+}
+
 void RateLimiter::process_request_queue()
 {
     const auto current_msecs = utils::time_since_epoch();
-    std::erase_if(m_in_flight, [&current_msecs, this](const auto& x) { return x < current_msecs - m_rate_period_msecs; });
-    unsigned requested_now = 0;
-    for (const auto& id : m_request_queue) {
-        if (m_in_flight.size() >= m_rate)
-            break;
+    while (!m_in_flight.empty() && m_in_flight.front() < current_msecs - m_rate_period_msecs)
+        m_in_flight.pop_front();
+    while (!m_request_queue.empty() && m_in_flight.size() < m_rate) {
+        const auto id = m_request_queue.front();
+        m_request_queue.pop_front();
         m_in_flight.push_back(current_msecs);
-        ++requested_now;
+        if (m_adaptive)
+            m_forwarded_at[id] = current_msecs;
         emit quad_requested(id);
     }
-    m_request_queue.erase(m_request_queue.cbegin(), m_request_queue.cbegin() + requested_now);
 
     if (!m_request_queue.empty()) {
         const auto age_of_oldest_in_flight = current_msecs - m_in_flight.front();
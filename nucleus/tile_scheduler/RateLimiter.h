@@ -18,23 +18,40 @@
 
 #pragma once
 
-#include <unordered_set>
+#include <deque>
+#include <limits>
+#include <unordered_map>
 
 #include <QObject>
 
 #include <radix/tile.h>
 
+#include "tile_types.h"
+
 class QTimer;
 
 namespace nucleus::tile_scheduler {
 
+// at most rate requests are forwarded within any period (sliding window).
+// if adaptive, the rate follows the responses (aimd): it grows additively while requests queue up, responses succeed and the latency is
+// stable. it is cut multiplicatively on errors (including timeouts, 429 and 503) and when the smoothed latency rises well above its minimum.
 class RateLimiter : public QObject
 {
     Q_OBJECT
     unsigned m_rate = 100;
     unsigned m_rate_period_msecs = 1000 * 1;
-    std::vector<tile::Id> m_request_queue;
-    std::vector<uint64_t> m_in_flight;
+    std::deque<tile::Id> m_request_queue;
+    std::deque<uint64_t> m_in_flight; // forwarding times, oldest first
+
+    bool m_adaptive = false;
+    unsigned m_min_rate = 10;
+    unsigned m_max_rate = 500;
+    unsigned m_additive_increase = 10; // per period
+    float m_multiplicative_decrease = 0.5f;
+    std::unordered_map<tile::Id, uint64_t, tile::Id::Hasher> m_forwarded_at;
+    float m_base_latency = std::numeric_limits<float>::max();
+    float m_smoothed_latency = -1; // not measured yet
+    uint64_t m_last_rate_change = 0;
     std::unique_ptr<QTimer> m_update_timer;
 
 public:
@@ -44,13 +61,29 @@ public:
     std::pair<unsigned, unsigned> limit() const;
     size_t queue_size() const;
 
+    void set_adaptive(bool enabled);
+    [[nodiscard]] bool adaptive() const;
+    void set_adaptive_bounds(unsigned min_rate, unsigned max_rate);
+    [[nodiscard]] std::pair<unsigned, unsigned> adaptive_bounds() const;
+    /// msecs, negative if nothing was measured yet
+    [[nodiscard]] float smoothed_latency() const;
+
 public slots:
     void request_quad(const tile::Id& id);
+    /// drops the request if it is still queued, otherwise the cancellation is passed on.
+    void cancel_quad(const tile::Id& id);
+    /// feedback for the adaptive rate
+    void receive_quad(const tile_types::TileQuad& quad);
 
 private slots:
     void process_request_queue();
 
+private:
+    void change_rate(unsigned new_rate, uint64_t current_msecs);
+
 signals:
     void quad_requested(const tile::Id& tile_id);
+    void quad_cancelled(const tile::Id& tile_id);
+    void rate_changed(unsigned rate);
 };
 }
@@ -18,14 +18,20 @@
 
 #include "Scheduler.h"
 
+#include <algorithm>
 #include <unordered_set>
 
 #include <QBuffer>
 #include <QDebug>
 #include <QNetworkInformation>
 #include <QStandardPaths>
+#ifdef ALP_ENABLE_THREADING
+#include <QThread>
+#include <QThreadPool>
+#endif
 #include <QTimer>
 
+#include "nucleus/tile_scheduler/DiskCacheWriter.h"
 #include "nucleus/tile_scheduler/utils.h"
 #include "nucleus/utils/tile_conversion.h"
 #include "radix/quad_tree.h"
@@ -45,6 +51,10 @@ Scheduler::Scheduler(const QByteArray& default_ortho_tile, const QByteArray& def
     connect(m_update_timer.get(), &QTimer::timeout, this, &Scheduler::send_quad_requests);
     connect(m_update_timer.get(), &QTimer::timeout, this, &Scheduler::update_gpu_quads);
 
+    m_retry_timer = std::make_unique<QTimer>(this);
+    m_retry_timer->setSingleShot(true);
+    connect(m_retry_timer.get(), &QTimer::timeout, this, &Scheduler::schedule_update);
+
     m_purge_timer = std::make_unique<QTimer>(this);
     m_purge_timer->setSingleShot(true);
     connect(m_purge_timer.get(), &QTimer::timeout, this, &Scheduler::purge_ram_cache);
@@ -55,25 +65,106 @@ Scheduler::Scheduler(const QByteArray& default_ortho_tile, const QByteArray& def
 
     m_default_ortho_tile = std::make_shared<QByteArray>(default_ortho_tile);
     m_default_height_tile = std::make_shared<QByteArray>(default_height_tile);
+    decode_default_tiles();
+
+    m_disk_cache_writer = std::make_unique<DiskCacheWriter>(&m_ram_cache, disk_cache_path());
+    m_disk_cache_writer->set_availability_path(availability_path());
+    connect(m_disk_cache_writer.get(), &DiskCacheWriter::write_finished, this, &Scheduler::finish_persist);
+#ifdef ALP_ENABLE_THREADING
+    m_decode_pool = std::make_unique<QThreadPool>();
+    m_decode_pool->setMaxThreadCount(QThread::idealThreadCount());
+    m_decode_pool->setObjectName("tile_decode_pool");
+
+    m_disk_cache_thread = std::make_unique<QThread>();
+    m_disk_cache_thread->setObjectName("tile_disk_cache_thread");
+    m_disk_cache_writer->moveToThread(m_disk_cache_thread.get());
+    m_disk_cache_thread->start();
+#endif
 }
 
-Scheduler::~Scheduler() = default;
+Scheduler::~Scheduler()
+{
+    // decoded quads are posted back to this object, the pool must not outlive it.
+    if (m_decode_pool)
+        m_decode_pool->waitForDone();
+    // writes that were requested, but didn't finish, are completed here. otherwise tiles would be lost on exit.
+    const auto unwritten = m_persist_in_flight || m_persist_pending || m_availability_dirty;
+    if (m_disk_cache_thread) {
+        m_disk_cache_thread->quit();
+        m_disk_cache_thread->wait();
+    }
+    if (unwritten) {
+        disconnect(m_disk_cache_writer.get(), nullptr, this, nullptr);
+        // the queued settings may not have reached the writer yet
+        m_disk_cache_writer->set_decoded_cache(m_decoded_disk_cache_enabled ? &m_decoded_cache : nullptr, decoded_disk_cache_path());
+        m_disk_cache_writer->write(m_availability_dirty ? std::optional(m_availability) : std::nullopt);
+    }
+}
 
 void Scheduler::update_camera(const camera::Definition& camera)
 {
     m_current_camera = camera;
+    m_full_gpu_update_needed = true;
+    const auto now = utils::time_since_epoch();
+    m_camera_history.push_back({ now, camera.position() });
+    std::erase_if(m_camera_history, [now](const CameraSample& s) { return s.time + m_camera_history_length < now; });
     schedule_update();
 }
 
-void Scheduler::receive_quad(const tile_types::TileQuad& new_quad)
+void Scheduler::update_animation_target(const camera::Definition& end_camera)
+{
+    m_animation_target = end_camera;
+    schedule_update();
+}
+
+void Scheduler::clear_animation_target()
+{
+    m_animation_target.reset();
+}
+
+void Scheduler::receive_quad(const tile_types::TileQuad& received_quad)
 {
     using Status = tile_types::NetworkInfo::Status;
+    // layers that didn't change since the last download (http 304) come without data, it is taken from the cache.
+    m_prefetch_in_flight.erase(received_quad.id);
+    auto new_quad = received_quad;
+    const auto n_unchanged_layers = fill_in_unchanged_layers(&new_quad);
+    if (!n_unchanged_layers.has_value()) {
+        // the stale data is gone (or incomplete), nothing failed on the network. without validators, the next request is unconditional.
+        if (auto cached = m_ram_cache.peak_at(new_quad.id)) {
+            for (auto& tile : cached->tiles) {
+                tile.ortho_validators = {};
+                tile.height_validators = {};
+            }
+            m_ram_cache.insert(*cached);
+        }
+        if (const auto iter = m_retries.find(new_quad.id); iter != m_retries.end())
+            iter->second.attempt_in_flight = false;
+        schedule_update();
+        update_stats();
+        return;
+    }
+    m_statistics.n_unchanged_layers += *n_unchanged_layers;
+    const auto update_decoded_cache = [&]() {
+        auto decoded = *n_unchanged_layers < 2 * new_quad.n_tiles ? std::nullopt : m_decoded_cache.peak_at(new_quad.id);
+        if (!decoded) {
+            m_decoded_cache.erase(new_quad.id);
+            return;
+        }
+        // nothing changed, the decoded quad stays valid.
+        decoded->source_timestamp = new_quad.network_info().timestamp;
+        m_decoded_cache.insert(*decoded);
+    };
 #ifdef __EMSCRIPTEN__
     // webassembly doesn't report 404 (well, probably it does, but not if there is a cors failure as well).
     // so we'll simply treat any 404 as network error.
     // however, we need to pass tiles with zoomlevel < 10, otherwise the top of the tree won't be built.
+    learn_availability(new_quad);
     if (new_quad.network_info().status == Status::Good || new_quad.id.zoom_level < 10) {
+        replace_preliminary(new_quad.id);
         m_ram_cache.insert(new_quad);
+        m_arrived_quads.insert(new_quad.id);
+        update_decoded_cache();
         schedule_purge();
         schedule_update();
         schedule_persist();
@@ -83,7 +174,12 @@ void Scheduler::receive_quad(const tile_types::TileQuad& new_quad)
     switch (new_quad.network_info().status) {
     case Status::Good:
     case Status::NotFound:
+        register_recovery(new_quad.id);
+        learn_availability(new_quad);
+        replace_preliminary(new_quad.id);
         m_ram_cache.insert(new_quad);
+        m_arrived_quads.insert(new_quad.id);
+        update_decoded_cache();
         schedule_purge();
         schedule_update();
         schedule_persist();
@@ -92,14 +188,44 @@ void Scheduler::receive_quad(const tile_types::TileQuad& new_quad)
         break;
     case Status::NetworkError:
         // do not persist the tile.
-        // do not reschedule retrieval (wait for user input or a reconnect signal).
         // do not purge (nothing was added, so no need to check).
-        // do nothing.
+        // retry later, without hammering the server (or a dead link).
+        register_network_error(new_quad.id);
+        update_stats();
         break;
     }
 #endif
 }
 
+void Scheduler::receive_preliminary_quad(const tile_types::TileQuad& quad)
+{
+    if (m_ram_cache.contains(quad.id))
+        return; // complete data, even if expired, is better than placeholders
+    auto preliminary = quad;
+    preliminary.preliminary = true; // never fresh, so that the request stays active until the complete quad arrives
+    m_ram_cache.insert(preliminary);
+    m_arrived_quads.insert(quad.id);
+    schedule_update();
+}
+
+void Scheduler::receive_cancellation(const tile::Id& id)
+{
+    m_prefetch_in_flight.erase(id);
+    const auto iter = m_retries.find(id);
+    if (iter != m_retries.end())
+        iter->second.attempt_in_flight = false;
+}
+
+void Scheduler::replace_preliminary(const tile::Id& id)
+{
+    // the gpu has a version with placeholder textures, it is patched with the next update
+    if (!m_gpu_cached.contains(id))
+        return;
+    const auto cached = m_ram_cache.peak_at(id);
+    if (cached && cached->preliminary)
+        m_gpu_outdated.insert(id);
+}
+
 void Scheduler::set_network_reachability(QNetworkInformation::Reachability reachability)
 {
     switch (reachability) {
@@ -109,6 +235,8 @@ void Scheduler::set_network_reachability(QNetworkInformation::Reachability reach
     case QNetworkInformation::Reachability::Unknown:
         qDebug() << "enabling network";
         m_network_requests_enabled = true;
+        for (auto& [id, retry] : m_retries)
+            retry.next_attempt = 0; // back online, no need to wait for the backoff
         schedule_update();
         break;
     case QNetworkInformation::Reachability::Disconnected:
@@ -122,23 +250,48 @@ void Scheduler::update_gpu_quads()
 {
     const auto should_refine = tile_scheduler::utils::refineFunctor(m_current_camera, m_aabb_decorator, m_permissible_screen_space_error, m_ortho_tile_size);
     std::vector<tile_types::TileQuad> gpu_candidates;
-    m_ram_cache.visit([this, &gpu_candidates, &should_refine](const tile_types::TileQuad& quad) {
+    const auto collect_candidates = [this, &gpu_candidates, &should_refine](const tile_types::TileQuad& quad) {
         if (!should_refine(quad.id))
             return false;
-        if (m_gpu_cached.contains(quad.id))
+        if (m_gpu_cached.contains(quad.id) && !m_gpu_outdated.contains(quad.id))
             return true;
 
         gpu_candidates.push_back(quad);
         return true;
-    });
+    };
+
+    if (m_full_gpu_update_needed) {
+        m_ram_cache.visit(collect_candidates);
+    } else {
+        // the camera didn't change, so the selection changes only below the arrived quads. their subtrees are visited, if the full
+        // traversal would reach them, i.e., if all ancestors are cached and refined. coarse quads first, as in the full traversal.
+        std::vector<tile::Id> arrived(m_arrived_quads.cbegin(), m_arrived_quads.cend());
+        std::sort(arrived.begin(), arrived.end(), [](const tile::Id& a, const tile::Id& b) { return a.zoom_level < b.zoom_level; });
+        for (const auto& id : arrived) {
+            bool reachable = true;
+            for (auto ancestor = id; reachable && ancestor.zoom_level > 0;) {
+                ancestor = ancestor.parent();
+                // an arrived ancestor was visited already, including this subtree (if it was reachable at all)
+                reachable = !m_arrived_quads.contains(ancestor) && m_ram_cache.contains(ancestor) && should_refine(ancestor);
+            }
+            if (reachable)
+                m_ram_cache.visit_subtree(id, collect_candidates);
+        }
+    }
 
     for (const auto& q : gpu_candidates) {
         m_gpu_cached.insert(tile_types::GpuCacheInfo { q.id });
     }
 
-    m_gpu_cached.visit([&should_refine](const tile_types::GpuCacheInfo& quad) {
-        return should_refine(quad.id);
-    });
+    // the visit refreshes the quads that are still needed, so that the purge keeps them (and their parents). stamps from the last
+    // full update are good enough, unless something has to be purged, as the new candidates would push out their own parents.
+    if (m_full_gpu_update_needed || m_gpu_cached.n_cached_objects() > m_gpu_quad_limit) {
+        m_gpu_cached.visit([&should_refine](const tile_types::GpuCacheInfo& quad) {
+            return should_refine(quad.id);
+        });
+    }
+    m_full_gpu_update_needed = false;
+    m_arrived_quads.clear();
 
     const auto superfluous_quads = m_gpu_cached.purge(m_gpu_quad_limit);
 
@@ -148,92 +301,476 @@ void Scheduler::update_gpu_quads()
     for (const auto& quad : superfluous_quads)
         superfluous_ids.insert(quad.id);
 
-    std::erase_if(gpu_candidates, [&superfluous_ids](const auto& quad) {
+    std::erase_if(gpu_candidates, [this, &superfluous_ids](const auto& quad) {
         if (superfluous_ids.contains(quad.id)) {
-            superfluous_ids.erase(quad.id);
+            if (!m_gpu_outdated.contains(quad.id))
+                superfluous_ids.erase(quad.id); // never reached the gpu
             return true;
         }
         return false;
     });
+    for (const auto& id : superfluous_ids)
+        m_gpu_outdated.erase(id);
+    for (const auto& quad : gpu_candidates)
+        m_gpu_outdated.erase(quad.id); // quads that are on the gpu already are patched there
 
-    std::vector<tile_types::GpuTileQuad> new_gpu_quads;
-    new_gpu_quads.reserve(gpu_candidates.size());
-    std::transform(gpu_candidates.cbegin(),
-                   gpu_candidates.cend(),
-                   std::back_inserter(new_gpu_quads),
-                   [this](const auto& quad) {
-                       // create GpuQuad based on cpu quad
-                       tile_types::GpuTileQuad gpu_quad;
-                       gpu_quad.id = quad.id;
-                       assert(quad.n_tiles == 4);
-                       for (unsigned i = 0; i < 4; ++i) {
-                           gpu_quad.tiles[i].id = quad.tiles[i].id;
-                           gpu_quad.tiles[i].bounds = m_aabb_decorator->aabb(quad.tiles[i].id);
-
-                           // unpacking the byte data takes long
-                           const auto* ortho_data = m_default_ortho_tile.get();
-                           if (quad.tiles[i].ortho->size()) {
-                               ortho_data = quad.tiles[i].ortho.get();
-                           }
-                           const auto ortho_qimage = nucleus::utils::tile_conversion::toQImage(*ortho_data);
-                           gpu_quad.tiles[i].ortho = std::make_shared<nucleus::utils::ColourTexture>(ortho_qimage, m_ortho_tile_compression_algorithm);
-
-                           const auto* height_data = m_default_height_tile.get();
-                           if (quad.tiles[i].height->size()) {
-                               height_data = quad.tiles[i].height.get();
-                           }
-                           auto heightraster = nucleus::utils::tile_conversion::qImage2uint16Raster(nucleus::utils::tile_conversion::toQImage(*height_data));
-                           gpu_quad.tiles[i].height = std::make_shared<nucleus::Raster<uint16_t>>(
-                               std::move(heightraster));
-                       }
-                       return gpu_quad;
-                   });
-
-    emit gpu_quads_updated(new_gpu_quads, { superfluous_ids.cbegin(), superfluous_ids.cend() });
+    // unpacking the byte data takes long. it is spread over the worker pool, and the results are sent from the event loop in the
+    // order of the traversal (i.e., coarse quads and their children first) as soon as a chunk of them is ready. removed quads go
+    // with the first chunk. the scheduler thread doesn't wait, everything the decoding needs is collected here.
+    // quads that were on the gpu before (or were persisted in an earlier session) are usually still in the decoded cache
+    // and don't need to be unpacked again. they are only used if they were made from the same quad and with the same compression.
+    const auto n_quads = gpu_candidates.size();
+    auto& update = m_gpu_updates.emplace_back();
+    update.quads.resize(n_quads);
+    update.ready.resize(n_quads, false);
+    update.cacheable.resize(n_quads, false);
+    update.deleted_quads.assign(superfluous_ids.cbegin(), superfluous_ids.cend());
+    std::vector<DecodeJob> jobs;
+    std::vector<size_t> job_indices;
+    for (size_t i = 0; i < n_quads; ++i) {
+        const auto& candidate = gpu_candidates[i];
+        update.cacheable[i] = !candidate.preliminary;
+        auto decoded = m_decoded_cache.peak_at(candidate.id);
+        const auto usable = decoded && decoded->source_timestamp == candidate.network_info().timestamp
+            && std::all_of(decoded->tiles.cbegin(), decoded->tiles.cend(), [this](const tile_types::GpuLayeredTile& tile) {
+                   return tile.ortho && tile.height && tile.ortho->format() == m_ortho_tile_compression_algorithm;
+               });
+        if (!usable) {
+            jobs.push_back(decode_job(candidate));
+            job_indices.push_back(i);
+            continue;
+        }
+        for (auto& tile : decoded->tiles)
+            tile.bounds = m_aabb_decorator->aabb(tile.id); // cheap, and the decorator could have changed
+        // the least recently sent quads are purged. touching doesn't write the quad to disk again, unlike inserting.
+        m_decoded_cache.touch(candidate.id);
+        update.quads[i] = std::move(*decoded);
+        update.ready[i] = true;
+    }
+    update.n_decoded = jobs.size();
+#ifdef ALP_ENABLE_THREADING
+    const auto serial = m_first_gpu_update + m_gpu_updates.size() - 1;
+    for (size_t j = 0; j < jobs.size(); ++j) {
+        m_decode_pool->start([this, serial, index = job_indices[j], job = std::move(jobs[j])]() {
+            auto gpu_quad = to_gpu_quad(job);
+            QMetaObject::invokeMethod(
+                this, [this, serial, index, gpu_quad = std::move(gpu_quad)]() { receive_decoded_quad(serial, index, gpu_quad); }, Qt::QueuedConnection);
+        });
+    }
+#else
+    for (size_t j = 0; j < jobs.size(); ++j) {
+        const auto index = job_indices[j];
+        update.quads[index] = to_gpu_quad(jobs[j]);
+        update.ready[index] = true;
+        if (update.cacheable[index])
+            m_decoded_cache.insert(update.quads[index]);
+    }
+#endif
+    send_ready_gpu_quads();
+    update_stats();
+}
+
+void Scheduler::receive_decoded_quad(uint64_t update, size_t index, const tile_types::GpuTileQuad& quad)
+{
+    assert(update >= m_first_gpu_update && update - m_first_gpu_update < m_gpu_updates.size());
+    auto& pending = m_gpu_updates[size_t(update - m_first_gpu_update)];
+    pending.quads[index] = quad;
+    pending.ready[index] = true;
+    if (pending.cacheable[index])
+        m_decoded_cache.insert(quad);
+    send_ready_gpu_quads();
     update_stats();
 }
 
+void Scheduler::send_ready_gpu_quads()
+{
+    while (!m_gpu_updates.empty()) {
+        auto& update = m_gpu_updates.front();
+        const auto n_quads = update.quads.size();
+        auto n_ready = update.n_sent;
+        while (n_ready < n_quads && update.ready[n_ready])
+            ++n_ready;
+        const auto complete = n_ready == n_quads;
+        if ((complete && (n_ready > update.n_sent || !update.first_chunk_sent)) || n_ready - update.n_sent >= m_gpu_quad_chunk_size) {
+            const auto begin = update.quads.cbegin() + ptrdiff_t(update.n_sent);
+            const auto quads = std::vector<tile_types::GpuTileQuad>(begin, update.quads.cbegin() + ptrdiff_t(n_ready));
+            emit gpu_quads_updated(quads, update.first_chunk_sent ? std::vector<tile::Id>() : update.deleted_quads);
+            update.first_chunk_sent = true;
+            update.n_sent = n_ready;
+        }
+        if (!complete)
+            return;
+
+        m_decoded_cache.purge(m_decoded_quad_limit, m_decoded_byte_limit, m_decoded_disk_byte_limit);
+        if (m_decoded_disk_cache_enabled && update.n_decoded > 0)
+            schedule_persist();
+        m_gpu_updates.pop_front();
+        ++m_first_gpu_update;
+    }
+}
+
+tile_types::GpuTileQuad Scheduler::to_gpu_quad(const DecodeJob& job)
+{
+    // create GpuQuad based on cpu quad
+    const auto& quad = job.quad;
+    tile_types::GpuTileQuad gpu_quad;
+    gpu_quad.id = quad.id;
+    gpu_quad.source_timestamp = quad.network_info().timestamp;
+    assert(quad.n_tiles == 4);
+    for (unsigned i = 0; i < 4; ++i) {
+        gpu_quad.tiles[i].id = quad.tiles[i].id;
+        gpu_quad.tiles[i].bounds = job.bounds[i];
+
+        // missing tiles share the default textures, which are decoded only once
+        if (quad.tiles[i].ortho->size()) {
+            const auto ortho_qimage = nucleus::utils::tile_conversion::toQImage(*quad.tiles[i].ortho);
+            gpu_quad.tiles[i].ortho = std::make_shared<nucleus::utils::ColourTexture>(ortho_qimage, job.format);
+        } else if (quad.tiles[i].height->size()) {
+            gpu_quad.tiles[i].ortho = ortho_from_parent(job, i); // preliminary, the ortho photo is still loading
+        } else {
+            gpu_quad.tiles[i].ortho = job.default_ortho_texture;
+        }
+
+        if (quad.tiles[i].height->size()) {
+            auto heightraster = nucleus::utils::tile_conversion::qImage2uint16Raster(nucleus::utils::tile_conversion::toQImage(*quad.tiles[i].height));
+            gpu_quad.tiles[i].height = std::make_shared<nucleus::Raster<uint16_t>>(std::move(heightraster));
+        } else {
+            gpu_quad.tiles[i].height = job.default_height_raster;
+        }
+    }
+    return gpu_quad;
+}
+
+Scheduler::DecodeJob Scheduler::decode_job(const tile_types::TileQuad& quad) const
+{
+    DecodeJob job;
+    job.quad = quad;
+    job.format = m_ortho_tile_compression_algorithm;
+    job.default_ortho_texture = m_default_ortho_texture;
+    job.default_height_raster = m_default_height_raster;
+    for (unsigned i = 0; i < quad.n_tiles; ++i) {
+        const auto& tile = quad.tiles[i];
+        job.bounds[i] = m_aabb_decorator->aabb(tile.id);
+        // the parent tile lives in the quad of the grand parent. the root tile has no quad.
+        if (!tile.height->size() || tile.ortho->size() || tile.id.zoom_level < 2)
+            continue;
+        const auto parent_id = tile.id.parent();
+        const auto parent_quad = m_ram_cache.peak_at(parent_id.parent());
+        if (!parent_quad)
+            continue;
+        const auto parent = std::find_if(parent_quad->tiles.cbegin(), parent_quad->tiles.cbegin() + parent_quad->n_tiles, [&parent_id](const auto& t) { return t.id == parent_id; });
+        if (parent != parent_quad->tiles.cbegin() + parent_quad->n_tiles)
+            job.parent_orthos[i] = parent->ortho;
+    }
+    return job;
+}
+
+std::shared_ptr<const nucleus::utils::ColourTexture> Scheduler::ortho_from_parent(const DecodeJob& job, unsigned index)
+{
+    const auto& parent_ortho = job.parent_orthos[index];
+    if (!parent_ortho || parent_ortho->isEmpty())
+        return job.default_ortho_texture;
+    const auto image = nucleus::utils::tile_conversion::toQImage(*parent_ortho);
+    if (image.isNull())
+        return job.default_ortho_texture;
+
+    // y points north in tile ids, but down in images
+    const auto& id = job.quad.tiles[index].id;
+    const auto parent_id = id.parent();
+    const auto half_width = image.width() / 2;
+    const auto half_height = image.height() / 2;
+    const auto dx = int(id.coords.x - 2 * parent_id.coords.x);
+    const auto dy = int(id.coords.y - 2 * parent_id.coords.y);
+    const auto quarter = image.copy(dx * half_width, (1 - dy) * half_height, half_width, half_height).scaled(image.size());
+    return std::make_shared<nucleus::utils::ColourTexture>(quarter, job.format);
+}
+
+void Scheduler::decode_default_tiles()
+{
+    const auto ortho_qimage = nucleus::utils::tile_conversion::toQImage(*m_default_ortho_tile);
+    m_default_ortho_texture = std::make_shared<nucleus::utils::ColourTexture>(ortho_qimage, m_ortho_tile_compression_algorithm);
+    auto heightraster = nucleus::utils::tile_conversion::qImage2uint16Raster(nucleus::utils::tile_conversion::toQImage(*m_default_height_tile));
+    m_default_height_raster = std::make_shared<nucleus::Raster<uint16_t>>(std::move(heightraster));
+}
+
 void Scheduler::send_quad_requests()
 {
     if (!m_network_requests_enabled)
         return;
     auto currently_active_tiles = tiles_for_current_camera_position();
     const auto current_time = utils::time_since_epoch();
-    std::erase_if(currently_active_tiles, [this, current_time](const tile::Id& id) {
-        return m_ram_cache.contains(id) && m_ram_cache.peak_at(id).network_info().timestamp + m_retirement_age_for_tile_cache > current_time;
+    const auto is_fresh = [this, current_time](const tile::Id& id) {
+        const auto quad = m_ram_cache.peak_at(id);
+        return quad && !quad->preliminary && quad->network_info().timestamp + m_retirement_age_for_tile_cache > current_time;
+    };
+    std::erase_if(m_retries, [this, current_time](const auto& entry) {
+        return current_time > entry.second.last_failure + 2 * uint64_t(m_retry_backoff_max); // out of view for a long time, or cancelled
     });
+    while (!m_retry_times.empty() && m_retry_times.front() + m_retry_budget_period <= current_time)
+        m_retry_times.pop_front();
+    // quads with network errors may be requested once their backoff elapsed. the retry budget is charged later, only for the quads
+    // that are actually requested (prefetch requests may be cut off).
+    const auto is_held_back = [this, current_time](const tile::Id& id) {
+        const auto iter = m_retries.find(id);
+        if (iter == m_retries.end() || iter->second.attempt_in_flight || iter->second.next_attempt <= current_time)
+            return false;
+        schedule_retry(iter->second.next_attempt);
+        return true;
+    };
+    std::erase_if(currently_active_tiles, [&](const tile::Id& id) { return is_fresh(id) || is_held_back(id); });
+    sort_by_request_priority(&currently_active_tiles, m_current_camera);
+
+    std::unordered_set<tile::Id, tile::Id::Hasher> prefetch_selection;
+    if (m_prefetch_enabled) {
+        // requests are served in order, so prefetched tiles come last and don't delay the current view.
+        std::unordered_set<tile::Id, tile::Id::Hasher> requested(currently_active_tiles.cbegin(), currently_active_tiles.cend());
+        std::vector<tile::Id> prefetch_tiles;
+        for (const auto& camera : prefetch_cameras()) {
+            std::vector<tile::Id> camera_tiles;
+            for (const auto& id : tiles_for_camera(camera)) {
+                if (!requested.contains(id) && !is_fresh(id) && !is_held_back(id)) {
+                    requested.insert(id);
+                    camera_tiles.push_back(id);
+                }
+            }
+            sort_by_request_priority(&camera_tiles, camera);
+            prefetch_tiles.insert(prefetch_tiles.end(), camera_tiles.cbegin(), camera_tiles.cend());
+        }
+        // the share limits new prefetch requests. the ones in flight stay, otherwise they would be cancelled mid-transfer whenever
+        // the number of missing tiles on screen changes, and requested again later.
+        auto n_new_prefetch = prefetch_tiles.size();
+        if (!currently_active_tiles.empty() && m_prefetch_bandwidth_share < 1.f) {
+            const auto share = double(m_prefetch_bandwidth_share);
+            n_new_prefetch = size_t(double(currently_active_tiles.size()) * share / (1.0 - share));
+        }
+        for (const auto& id : prefetch_tiles) {
+            const auto in_flight = m_prefetch_in_flight.contains(id);
+            if (!in_flight && n_new_prefetch == 0)
+                continue;
+            if (!in_flight)
+                --n_new_prefetch;
+            currently_active_tiles.push_back(id);
+            prefetch_selection.insert(id);
+        }
+    }
+
+    // retries take from the budget in request order, the ones that don't fit wait for the next period.
+    std::vector<tile::Id> requested_tiles;
+    requested_tiles.reserve(currently_active_tiles.size());
+    for (const auto& id : currently_active_tiles) {
+        const auto iter = m_retries.find(id);
+        if (iter != m_retries.end() && !iter->second.attempt_in_flight) {
+            if (m_retry_times.size() >= m_retry_budget) {
+                schedule_retry(m_retry_times.front() + m_retry_budget_period);
+                continue;
+            }
+            m_retry_times.push_back(current_time);
+            iter->second.attempt_in_flight = true;
+            ++m_statistics.n_retries;
+        }
+        requested_tiles.push_back(id);
+    }
+    currently_active_tiles = std::move(requested_tiles);
+    m_prefetch_in_flight.clear();
+    for (const auto& id : currently_active_tiles) {
+        if (prefetch_selection.contains(id))
+            m_prefetch_in_flight.insert(id);
+    }
+    // attempts that are not requested anymore are cancelled or dropped from the queue downstream, they won't be delivered.
+    const std::unordered_set<tile::Id, tile::Id::Hasher> requested_ids(currently_active_tiles.cbegin(), currently_active_tiles.cend());
+    for (auto& [id, retry] : m_retries) {
+        if (!requested_ids.contains(id))
+            retry.attempt_in_flight = false;
+    }
+
+    // requested quads that are in the cache are expired. they keep rendering, while the sources ask whether they changed.
+    std::vector<tile_types::TileValidators> validators;
+    for (const auto& id : currently_active_tiles) {
+        const auto quad = m_ram_cache.peak_at(id);
+        if (!quad)
+            continue;
+        for (unsigned i = 0; i < quad->n_tiles; ++i) {
+            const auto& tile = quad->tiles[i];
+            if (!tile.ortho_validators.empty() || !tile.height_validators.empty())
+                validators.push_back({ tile.id, tile.ortho_validators, tile.height_validators });
+        }
+    }
+    if (!validators.empty())
+        emit revalidation_requested(validators);
     emit quads_requested(currently_active_tiles);
 }
 
+void Scheduler::learn_availability(const tile_types::TileQuad& quad)
+{
+    // missing tiles have no descendants, their subtrees won't be refined or requested until the entry expires.
+    // the status is joined over both layers, so a tile that is missing in only one dataset counts as missing. that's intended: the
+    // layer assembler drops the data of both layers in that case, and the renderer can't draw heights without ortho photos or the
+    // other way round. refining there would replace the complete parent with default tiles.
+    const auto expires_at = utils::time_since_epoch() + m_retirement_age_for_tile_cache;
+    for (unsigned i = 0; i < quad.n_tiles; ++i) {
+        const auto& tile = quad.tiles[i];
+        if (tile.network_info.status == tile_types::NetworkInfo::Status::NotFound && m_availability.available(tile.id)) {
+            m_availability.mark_unavailable(tile.id, expires_at);
+            m_availability_dirty = true;
+            ++m_availability_version;
+            m_current_cut.invalidate(tile.id);
+        }
+    }
+}
+
+std::optional<unsigned> Scheduler::fill_in_unchanged_layers(tile_types::TileQuad* quad) const
+{
+    unsigned n_unchanged = 0;
+    for (unsigned i = 0; i < quad->n_tiles; ++i)
+        n_unchanged += unsigned(!quad->tiles[i].ortho) + unsigned(!quad->tiles[i].height);
+    if (n_unchanged == 0)
+        return 0u;
+    const auto cached = m_ram_cache.peak_at(quad->id);
+    if (!cached)
+        return std::nullopt; // purged while the revalidation was in flight
+    for (unsigned i = 0; i < quad->n_tiles; ++i) {
+        auto& tile = quad->tiles[i];
+        const auto cached_tile = std::find_if(cached->tiles.cbegin(), cached->tiles.cbegin() + cached->n_tiles, [&tile](const auto& t) { return t.id == tile.id; });
+        if (cached_tile == cached->tiles.cbegin() + cached->n_tiles)
+            return std::nullopt;
+        if (!tile.ortho)
+            tile.ortho = cached_tile->ortho;
+        if (!tile.height)
+            tile.height = cached_tile->height;
+        if (!tile.ortho || !tile.height)
+            return std::nullopt;
+    }
+    return n_unchanged;
+}
+
+void Scheduler::register_network_error(const tile::Id& id)
+{
+    const auto current_time = utils::time_since_epoch();
+    auto& retry = m_retries[id];
+    if (retry.n_failures == 0)
+        retry.first_failure = current_time;
+    ++retry.n_failures;
+    retry.last_failure = current_time;
+    retry.attempt_in_flight = false;
+    uint64_t backoff = 0; // the first retry goes out right away, most errors on mobile links are transient
+    if (retry.n_failures > 1) {
+        const auto exponent = std::min(retry.n_failures - 2, 20u);
+        backoff = std::min(uint64_t(m_retry_backoff_base) << exponent, uint64_t(m_retry_backoff_max));
+        // jitter, so that quads failing together (e.g., after a dropout) don't come back together
+        backoff = uint64_t(double(backoff) * std::uniform_real_distribution<double>(0.5, 1.0)(m_random_engine));
+    }
+    retry.next_attempt = current_time + backoff;
+    schedule_retry(retry.next_attempt);
+}
+
+void Scheduler::register_recovery(const tile::Id& id)
+{
+    const auto iter = m_retries.find(id);
+    if (iter == m_retries.end())
+        return;
+    m_sum_of_recovery_times += utils::time_since_epoch() - iter->second.first_failure;
+    m_retries.erase(iter);
+    ++m_statistics.n_recovered_quads;
+    m_statistics.mean_time_to_recovery = m_sum_of_recovery_times / m_statistics.n_recovered_quads;
+}
+
+void Scheduler::schedule_retry(uint64_t at)
+{
+    const auto current_time = utils::time_since_epoch();
+    const auto delay = int(std::min(at > current_time ? at - current_time : 0, uint64_t(std::numeric_limits<int>::max())));
+    if (!m_retry_timer->isActive() || m_retry_timer->remainingTime() > delay)
+        m_retry_timer->start(delay);
+}
+
+void Scheduler::set_retry_backoff(unsigned int base_msecs, unsigned int max_msecs)
+{
+    assert(base_msecs <= max_msecs);
+    m_retry_backoff_base = base_msecs;
+    m_retry_backoff_max = max_msecs;
+}
+
+void Scheduler::set_retry_budget(unsigned int n_retries, unsigned int period_msecs)
+{
+    m_retry_budget = n_retries;
+    m_retry_budget_period = period_msecs;
+}
+
+void Scheduler::sort_by_request_priority(std::vector<tile::Id>* ids, const camera::Definition& camera) const
+{
+    // the list is sent again after every camera update, so queued requests are reprioritised as the camera moves.
+    const auto priority = tile_scheduler::utils::request_priority_functor(camera, m_aabb_decorator, m_ortho_tile_size);
+    std::vector<std::pair<tile_scheduler::utils::RequestPriority, tile::Id>> keyed;
+    keyed.reserve(ids->size());
+    for (const auto& id : *ids)
+        keyed.emplace_back(priority(id), id);
+    std::stable_sort(keyed.begin(), keyed.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    std::transform(keyed.cbegin(), keyed.cend(), ids->begin(), [](const auto& entry) { return entry.second; });
+}
+
+std::vector<nucleus::camera::Definition> Scheduler::prefetch_cameras() const
+{
+    std::vector<camera::Definition> cameras;
+    if (m_animation_target)
+        cameras.push_back(m_animation_target.value());
+
+    // the velocity is estimated from the camera updates in the last m_camera_history_length msecs. only the position is extrapolated.
+    if (m_camera_history.size() >= 2 && m_camera_history.back().time + m_camera_history_length >= utils::time_since_epoch()) {
+        const auto& oldest = m_camera_history.front();
+        const auto& newest = m_camera_history.back();
+        if (newest.time > oldest.time) {
+            const auto velocity = (newest.position - oldest.position) / double(newest.time - oldest.time); // per msec
+            if (glm::length(velocity) > 0.0) {
+                auto predicted = m_current_camera;
+                predicted.move(velocity * double(m_prefetch_lookahead));
+                cameras.push_back(predicted);
+            }
+        }
+    }
+    return cameras;
+}
+
 void Scheduler::purge_ram_cache()
 {
-    if (m_ram_cache.n_cached_objects() <= unsigned(float(m_ram_quad_limit) * 1.05f)){
+    if (m_ram_cache.n_cached_objects() <= unsigned(float(m_ram_quad_limit) * 1.05f) && m_ram_cache.n_bytes() <= uint64_t(double(m_ram_byte_limit) * 1.05)) {
         return;
     }
 
     const auto should_refine = tile_scheduler::utils::refineFunctor(m_current_camera, m_aabb_decorator, m_permissible_screen_space_error, m_ortho_tile_size);
     m_ram_cache.visit(
         [&should_refine](const tile_types::TileQuad& quad) { return should_refine(quad.id); });
-    m_ram_cache.purge(m_ram_quad_limit);
+    m_ram_cache.purge(m_ram_quad_limit, m_ram_byte_limit);
     update_stats();
 }
 
 void Scheduler::persist_tiles()
 {
-    const auto start = std::chrono::steady_clock::now();
-    const auto r = m_ram_cache.write_to_disk(disk_cache_path());
-    const auto diff = std::chrono::steady_clock::now() - start;
+    if (m_persist_in_flight) {
+        m_persist_pending = true;
+        return;
+    }
+    m_persist_in_flight = true;
 
-    if (diff > std::chrono::milliseconds(50))
-        qDebug() << QString("Scheduler::persist_tiles took %1ms for %2 quads.")
-                        .arg(std::chrono::duration_cast<std::chrono::milliseconds>(diff).count())
-                        .arg(m_ram_cache.n_cached_objects());
+    // the availability is small (only roots of missing subtrees), a snapshot goes along with the tiles.
+    std::optional<TileAvailability> availability;
+    if (m_availability_dirty) {
+        m_availability.prune();
+        availability = m_availability;
+        m_availability_version_in_flight = m_availability_version;
+    }
+    auto* writer = m_disk_cache_writer.get();
+    QMetaObject::invokeMethod(writer, [writer, availability = std::move(availability)]() { writer->write(availability); }, Qt::QueuedConnection);
+}
 
-    if (!r.has_value()) {
-        qDebug() << QString("Writing tiles to disk into %1 failed: %2. Removing all files.")
-                        .arg(QString::fromStdString(disk_cache_path().string()))
-                        .arg(QString::fromStdString(r.error()));
-        std::filesystem::remove_all(disk_cache_path());
+void Scheduler::finish_persist(bool success, bool availability_written)
+{
+    m_persist_in_flight = false;
+    // changes that came in during the write are written next time
+    if (availability_written && m_availability_version_in_flight == m_availability_version)
+        m_availability_dirty = false;
+    emit tiles_persisted(success);
+    if (m_persist_pending) {
+        m_persist_pending = false;
+        persist_tiles();
     }
 }
 
@@ -264,31 +801,65 @@ void Scheduler::update_stats()
 {
     m_statistics.n_tiles_in_ram_cache = m_ram_cache.n_cached_objects();
     m_statistics.n_tiles_in_gpu_cache = m_gpu_cached.n_cached_objects();
+    m_statistics.n_bytes_in_ram_cache = m_ram_cache.n_bytes();
+    m_statistics.n_bytes_in_decoded_cache = m_decoded_cache.n_bytes();
+    m_statistics.n_quads_awaiting_retry = unsigned(m_retries.size());
+    m_statistics.n_unavailable_subtrees = unsigned(m_availability.n_entries());
     emit statistics_updated(m_statistics);
 }
 
 void Scheduler::read_disk_cache()
 {
+    if (std::filesystem::exists(availability_path())) {
+        const auto availability_r = m_availability.read_from_disk(availability_path());
+        if (!availability_r.has_value()) {
+            qDebug() << QString("Reading tile availability (%1) failed: %2").arg(QString::fromStdString(availability_path().string())).arg(QString::fromStdString(availability_r.error()));
+            std::filesystem::remove(availability_path());
+        }
+        m_availability.prune();
+        m_current_cut.reset();
+    }
     const auto r = m_ram_cache.read_from_disk(disk_cache_path());
     if (r.has_value()) {
+        m_full_gpu_update_needed = true;
         update_stats();
     } else {
-        qDebug() << QString("Reading tiles from disk cache (%1) failed: \n%2\nRemoving all files.")
+        qDebug() << QString("Reading tiles from disk cache (%1) failed: \n%2\nRemoving the tile pack.")
                         .arg(QString::fromStdString(disk_cache_path().string()))
                         .arg(QString::fromStdString(r.error()));
-        std::filesystem::remove_all(disk_cache_path());
+        m_ram_cache.remove_from_disk(disk_cache_path()); // the decoded quads and the availability are in the same directory
+        return;
+    }
+
+    if (!m_decoded_disk_cache_enabled)
+        return;
+    const auto decoded_r = m_decoded_cache.read_from_disk(decoded_disk_cache_path());
+    if (decoded_r.has_value()) {
+        update_stats();
+    } else {
+        qDebug() << QString("Reading decoded tiles from disk cache (%1) failed: \n%2\nRemoving the decoded tile pack.")
+                        .arg(QString::fromStdString(decoded_disk_cache_path().string()))
+                        .arg(QString::fromStdString(decoded_r.error()));
+        m_decoded_cache.remove_from_disk(decoded_disk_cache_path());
     }
 }
 
-std::vector<tile::Id> Scheduler::tiles_for_current_camera_position() const
+std::vector<tile::Id> Scheduler::tiles_for_current_camera_position()
+{
+    // the camera moves little between updates, only the boundaries of the cut are evaluated again
+    m_current_cut.update(m_current_camera, m_aabb_decorator, m_permissible_screen_space_error, m_ortho_tile_size, [this](const tile::Id& id) {
+        return m_availability.available(id);
+    });
+    return { m_current_cut.inner_nodes().cbegin(), m_current_cut.inner_nodes().cend() };
+}
+
+std::vector<tile::Id> Scheduler::tiles_for_camera(const camera::Definition& camera) const
 {
     std::vector<tile::Id> all_inner_nodes;
+    const auto should_refine = tile_scheduler::utils::refineFunctor(camera, m_aabb_decorator, m_permissible_screen_space_error, m_ortho_tile_size);
     const auto all_leaves = quad_tree::onTheFlyTraverse(
         tile::Id{0, {0, 0}},
-        tile_scheduler::utils::refineFunctor(m_current_camera,
-                                             m_aabb_decorator,
-                                             m_permissible_screen_space_error,
-                                             m_ortho_tile_size),
+        [this, &should_refine](const tile::Id& id) { return should_refine(id) && m_availability.available(id); },
         [&all_inner_nodes](const tile::Id &v) {
             all_inner_nodes.push_back(v);
             return v.children();
@@ -302,7 +873,10 @@ nucleus::utils::ColourTexture::Format Scheduler::ortho_tile_compression_algorith
 
 void Scheduler::set_ortho_tile_compression_algorithm(nucleus::utils::ColourTexture::Format new_ortho_tile_compression_algorithm)
 {
+    if (m_ortho_tile_compression_algorithm == new_ortho_tile_compression_algorithm)
+        return;
     m_ortho_tile_compression_algorithm = new_ortho_tile_compression_algorithm;
+    decode_default_tiles(); // decoded quads with a different format are replaced when they are used next
 }
 
 void Scheduler::set_retirement_age_for_tile_cache(unsigned int new_retirement_age_for_tile_cache)
@@ -335,6 +909,22 @@ Cache<tile_types::TileQuad>& Scheduler::ram_cache()
     return m_ram_cache;
 }
 
+const Cache<tile_types::GpuTileQuad>& Scheduler::decoded_cache() const
+{
+    return m_decoded_cache;
+}
+
+const TileAvailability& Scheduler::availability() const
+{
+    return m_availability;
+}
+
+TileAvailability& Scheduler::availability()
+{
+    m_current_cut.reset(); // it might be changed
+    return m_availability;
+}
+
 QByteArray Scheduler::white_jpeg_tile(unsigned int size)
 {
     QImage default_tile(QSize { int(size), int(size) }, QImage::Format_ARGB32);
@@ -364,6 +954,16 @@ std::filesystem::path Scheduler::disk_cache_path()
     return  base_path / "tile_cache";
 }
 
+std::filesystem::path Scheduler::decoded_disk_cache_path()
+{
+    return disk_cache_path() / "decoded";
+}
+
+std::filesystem::path Scheduler::availability_path()
+{
+    return disk_cache_path() / "availability.alp";
+}
+
 void Scheduler::set_purge_timeout(unsigned int new_purge_timeout)
 {
     assert(new_purge_timeout < unsigned(std::numeric_limits<int>::max()));
@@ -374,24 +974,111 @@ void Scheduler::set_purge_timeout(unsigned int new_purge_timeout)
     }
 }
 
+void Scheduler::set_decoded_byte_limit(uint64_t new_decoded_byte_limit)
+{
+    m_decoded_byte_limit = new_decoded_byte_limit;
+    m_decoded_cache.purge(m_decoded_quad_limit, m_decoded_byte_limit, m_decoded_disk_byte_limit);
+}
+
+uint64_t Scheduler::decoded_byte_limit() const
+{
+    return m_decoded_byte_limit;
+}
+
+void Scheduler::set_decoded_disk_byte_limit(uint64_t new_decoded_disk_byte_limit)
+{
+    m_decoded_disk_byte_limit = new_decoded_disk_byte_limit;
+    m_decoded_cache.purge(m_decoded_quad_limit, m_decoded_byte_limit, m_decoded_disk_byte_limit);
+}
+
+uint64_t Scheduler::decoded_disk_byte_limit() const
+{
+    return m_decoded_disk_byte_limit;
+}
+
+void Scheduler::set_decoded_disk_cache_enabled(bool enabled)
+{
+    m_decoded_disk_cache_enabled = enabled;
+    auto* cache = enabled ? &m_decoded_cache : nullptr;
+    QMetaObject::invokeMethod(
+        m_disk_cache_writer.get(), [writer = m_disk_cache_writer.get(), cache]() { writer->set_decoded_cache(cache, decoded_disk_cache_path()); }, Qt::QueuedConnection);
+}
+
+bool Scheduler::decoded_disk_cache_enabled() const
+{
+    return m_decoded_disk_cache_enabled;
+}
+
+void Scheduler::set_prefetch_enabled(bool enabled)
+{
+    m_prefetch_enabled = enabled;
+}
+
+bool Scheduler::prefetch_enabled() const
+{
+    return m_prefetch_enabled;
+}
+
+void Scheduler::set_prefetch_bandwidth_share(float share)
+{
+    assert(share >= 0.f && share <= 1.f);
+    m_prefetch_bandwidth_share = share;
+}
+
+float Scheduler::prefetch_bandwidth_share() const
+{
+    return m_prefetch_bandwidth_share;
+}
+
+void Scheduler::set_prefetch_lookahead(unsigned msecs)
+{
+    m_prefetch_lookahead = msecs;
+}
+
 void Scheduler::set_ram_quad_limit(unsigned int new_ram_quad_limit)
 {
     m_ram_quad_limit = new_ram_quad_limit;
 }
 
+void Scheduler::set_ram_byte_limit(uint64_t new_ram_byte_limit)
+{
+    m_ram_byte_limit = new_ram_byte_limit;
+}
+
+uint64_t Scheduler::ram_byte_limit() const
+{
+    return m_ram_byte_limit;
+}
+
+void Scheduler::set_gpu_quad_chunk_size(unsigned int new_gpu_quad_chunk_size)
+{
+    assert(new_gpu_quad_chunk_size > 0);
+    m_gpu_quad_chunk_size = new_gpu_quad_chunk_size;
+}
+
+unsigned Scheduler::n_pending_gpu_updates() const
+{
+    return unsigned(m_gpu_updates.size());
+}
+
 void Scheduler::set_gpu_quad_limit(unsigned int new_gpu_quad_limit)
 {
     m_gpu_quad_limit = new_gpu_quad_limit;
+    m_full_gpu_update_needed = true;
 }
 
 void Scheduler::set_aabb_decorator(const utils::AabbDecoratorPtr& new_aabb_decorator)
 {
     m_aabb_decorator = new_aabb_decorator;
+    m_full_gpu_update_needed = true;
+    m_current_cut.reset();
 }
 
 void Scheduler::set_permissible_screen_space_error(float new_permissible_screen_space_error)
 {
     m_permissible_screen_space_error = new_permissible_screen_space_error;
+    m_full_gpu_update_needed = true;
+    m_current_cut.reset();
 }
 
 bool Scheduler::enabled() const
@@ -18,19 +18,30 @@
 
 #pragma once
 
+#include <array>
+#include <deque>
 #include <memory>
+#include <optional>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <QNetworkInformation>
 #include <QObject>
 
 #include "Cache.h"
+#include "QuadTreeCut.h"
+#include "TileAvailability.h"
 #include "nucleus/camera/Definition.h"
 #include "radix/tile.h"
 #include "tile_types.h"
 
+class QThread;
+class QThreadPool;
 class QTimer;
 
 namespace nucleus::tile_scheduler {
+class DiskCacheWriter;
 namespace utils {
     class AabbDecorator;
     using AabbDecoratorPtr = std::shared_ptr<AabbDecorator>;
@@ -42,6 +53,14 @@ public:
     struct Statistics {
         unsigned n_tiles_in_ram_cache = 0;
         unsigned n_tiles_in_gpu_cache = 0;
+        uint64_t n_bytes_in_ram_cache = 0;
+        uint64_t n_bytes_in_decoded_cache = 0;
+        unsigned n_retries = 0;
+        unsigned n_quads_awaiting_retry = 0;
+        unsigned n_recovered_quads = 0;
+        uint64_t mean_time_to_recovery = 0; // msecs from the first network error to a successful response
+        unsigned n_unchanged_layers = 0; // expired tile layers that the server confirmed as unchanged (http 304)
+        unsigned n_unavailable_subtrees = 0; // known to be beyond the coverage of the datasets, neither refined nor requested
     };
 
     explicit Scheduler(QObject* parent = nullptr);
@@ -59,16 +78,53 @@ public:
 
     void set_gpu_quad_limit(unsigned int new_gpu_quad_limit);
 
+    /// with threading, new gpu quads are decoded in parallel and sent in chunks of at least this size as soon as they are ready.
+    void set_gpu_quad_chunk_size(unsigned int new_gpu_quad_chunk_size);
+    /// gpu updates whose quads are still being decoded. they are sent from the event loop, in the order of the updates.
+    [[nodiscard]] unsigned n_pending_gpu_updates() const;
+
+    /// memory budget for decoded quads, which are kept after leaving the gpu so that they can be sent again without decoding.
+    void set_decoded_byte_limit(uint64_t new_decoded_byte_limit);
+    [[nodiscard]] uint64_t decoded_byte_limit() const;
+
+    /// decoded quads are persisted next to the ram cache, so that warm starts don't decode and compress textures again. off by
+    /// default, it costs up to decoded_disk_byte_limit of disk space. enable it before read_disk_cache.
+    void set_decoded_disk_cache_enabled(bool enabled);
+    [[nodiscard]] bool decoded_disk_cache_enabled() const;
+    /// size budget of the decoded quads including the ones that are only on disk, i.e., roughly the size of the decoded pack file.
+    /// the default is 1 GiB, i.e., about 1000 quads with uncompressed textures.
+    void set_decoded_disk_byte_limit(uint64_t new_decoded_disk_byte_limit);
+    [[nodiscard]] uint64_t decoded_disk_byte_limit() const;
+
     void set_ram_quad_limit(unsigned int new_ram_quad_limit);
 
+    /// memory budget of the ram cache. quads are purged when either this or the quad limit is exceeded.
+    void set_ram_byte_limit(uint64_t new_ram_byte_limit);
+    [[nodiscard]] uint64_t ram_byte_limit() const;
+
     void set_purge_timeout(unsigned int new_purge_timeout);
 
+    /// prefetching requests tiles for where the camera is going to be, i.e., the target of an animation, and the position extrapolated
+    /// from recent camera movement. these requests go after the ones for the current view and make up at most bandwidth_share of them
+    /// (all of them, if nothing is missing in the current view). the share limits new prefetch requests, the ones in flight stay.
+    void set_prefetch_enabled(bool enabled);
+    [[nodiscard]] bool prefetch_enabled() const;
+    void set_prefetch_bandwidth_share(float share);
+    [[nodiscard]] float prefetch_bandwidth_share() const;
+    void set_prefetch_lookahead(unsigned msecs);
+
     const Cache<tile_types::TileQuad>& ram_cache() const;
     Cache<tile_types::TileQuad>& ram_cache();
+    const Cache<tile_types::GpuTileQuad>& decoded_cache() const;
+    /// learned from NotFound responses and persisted with the disk cache. metadata files can be read into it as well.
+    const TileAvailability& availability() const;
+    TileAvailability& availability();
 
     static QByteArray white_jpeg_tile(unsigned size);
     static QByteArray black_png_tile(unsigned size);
     static std::filesystem::path disk_cache_path();
+    static std::filesystem::path decoded_disk_cache_path();
+    static std::filesystem::path availability_path();
 
     [[nodiscard]] unsigned int persist_timeout() const;
     void set_persist_timeout(unsigned int new_persist_timeout);
@@ -76,6 +132,12 @@ public:
     void read_disk_cache();
 
     void set_retirement_age_for_tile_cache(unsigned int new_retirement_age_for_tile_cache);
+
+    /// quads with network errors are retried immediately once, then with exponential backoff (base, 2*base, .. up to max) and jitter.
+    /// retries go into the normal request list, i.e., they are ordered like fresh requests.
+    void set_retry_backoff(unsigned base_msecs, unsigned max_msecs);
+    /// at most n_retries within any period, for all quads together.
+    void set_retry_budget(unsigned n_retries, unsigned period_msecs);
     
     nucleus::utils::ColourTexture::Format ortho_tile_compression_algorithm() const;
     void set_ortho_tile_compression_algorithm(nucleus::utils::ColourTexture::Format new_ortho_tile_compression_algorithm);
@@ -84,23 +146,60 @@ signals:
     void statistics_updated(Statistics stats);
     void quad_received(const tile::Id& ids);
     void quads_requested(const std::vector<tile::Id>& ids);
+    /// emitted before quads_requested, for the expired tiles in the request.
+    void revalidation_requested(const std::vector<tile_types::TileValidators>& validators);
     void gpu_quads_updated(const std::vector<tile_types::GpuTileQuad>& new_quads, const std::vector<tile::Id>& deleted_quads);
+    void tiles_persisted(bool success);
 
 public slots:
     void update_camera(const nucleus::camera::Definition& camera);
-    void receive_quad(const tile_types::TileQuad& new_quad);
+    void update_animation_target(const nucleus::camera::Definition& end_camera);
+    void clear_animation_target();
+    void receive_quad(const tile_types::TileQuad& received_quad);
+    /// heights without ortho photos. they are shown with a part of the parent's ortho photo, until the complete quad arrives.
+    void receive_preliminary_quad(const tile_types::TileQuad& quad);
+    /// the request was dropped downstream, e.g., by the slot limiter. a retry of it can be requested again.
+    void receive_cancellation(const tile::Id& id);
     void set_network_reachability(QNetworkInformation::Reachability reachability);
     void update_gpu_quads();
     void send_quad_requests();
     void purge_ram_cache();
+    /// hands the write over to the disk cache thread and returns immediately. requests during a write are batched into one follow up write.
     void persist_tiles();
 
+private slots:
+    void finish_persist(bool success, bool availability_written);
+
 protected:
     void schedule_update();
     void schedule_purge();
     void schedule_persist();
     void update_stats();
-    std::vector<tile::Id> tiles_for_current_camera_position() const;
+    std::vector<tile::Id> tiles_for_current_camera_position();
+    std::vector<tile::Id> tiles_for_camera(const camera::Definition& camera) const;
+    std::vector<camera::Definition> prefetch_cameras() const;
+    void sort_by_request_priority(std::vector<tile::Id>* ids, const camera::Definition& camera) const;
+    // everything that is needed for decoding a quad. it is collected on the scheduler thread, the decode pool touches nothing else.
+    struct DecodeJob {
+        tile_types::TileQuad quad;
+        std::array<tile::SrsAndHeightBounds, 4> bounds = {};
+        std::array<std::shared_ptr<QByteArray>, 4> parent_orthos = {}; // preliminary tiles show a quarter of the parent's ortho photo
+        nucleus::utils::ColourTexture::Format format = nucleus::utils::ColourTexture::Format::Uncompressed_RGBA;
+        std::shared_ptr<const nucleus::utils::ColourTexture> default_ortho_texture;
+        std::shared_ptr<const nucleus::Raster<uint16_t>> default_height_raster;
+    };
+    DecodeJob decode_job(const tile_types::TileQuad& quad) const;
+    static tile_types::GpuTileQuad to_gpu_quad(const DecodeJob& job); // called concurrently from the decode pool
+    static std::shared_ptr<const nucleus::utils::ColourTexture> ortho_from_parent(const DecodeJob& job, unsigned index);
+    void receive_decoded_quad(uint64_t update, size_t index, const tile_types::GpuTileQuad& quad);
+    void send_ready_gpu_quads();
+    void decode_default_tiles();
+    void register_network_error(const tile::Id& id);
+    void register_recovery(const tile::Id& id);
+    void schedule_retry(uint64_t at);
+    std::optional<unsigned> fill_in_unchanged_layers(tile_types::TileQuad* quad) const;
+    void learn_availability(const tile_types::TileQuad& quad);
+    void replace_preliminary(const tile::Id& id);
 
 private:
     unsigned m_retirement_age_for_tile_cache = 10u * 24u * 3600u * 1000u; // 10 days
@@ -109,7 +208,13 @@ private:
     unsigned m_purge_timeout = 1000;
     unsigned m_persist_timeout = 10000;
     unsigned m_gpu_quad_limit = 300;
+    unsigned m_gpu_quad_chunk_size = 64;
     unsigned m_ram_quad_limit = 15000;
+    uint64_t m_ram_byte_limit = uint64_t(2) * 1024 * 1024 * 1024;
+    uint64_t m_decoded_byte_limit = uint64_t(256) * 1024 * 1024;
+    unsigned m_decoded_quad_limit = 4000; // quads that are not paged in don't count towards the byte limit
+    uint64_t m_decoded_disk_byte_limit = uint64_t(1) * 1024 * 1024 * 1024; // this one bounds the disk tier
+    bool m_decoded_disk_cache_enabled = false;
     static constexpr unsigned m_ortho_tile_size = 256;
     static constexpr unsigned m_height_tile_size = 65;
     bool m_enabled = false;
@@ -118,12 +223,67 @@ private:
     std::unique_ptr<QTimer> m_update_timer;
     std::unique_ptr<QTimer> m_purge_timer;
     std::unique_ptr<QTimer> m_persist_timer;
+    bool m_persist_in_flight = false;
+    bool m_persist_pending = false;
+    bool m_availability_dirty = false;
+    uint64_t m_availability_version = 0; // incremented on every change, so that a finished write knows whether it is still current
+    uint64_t m_availability_version_in_flight = 0;
     camera::Definition m_current_camera;
+    struct CameraSample {
+        uint64_t time;
+        glm::dvec3 position;
+    };
+    std::vector<CameraSample> m_camera_history; // oldest first
+    std::optional<camera::Definition> m_animation_target;
+    bool m_prefetch_enabled = true;
+    float m_prefetch_bandwidth_share = 0.25f;
+    std::unordered_set<tile::Id, tile::Id::Hasher> m_prefetch_in_flight; // requested as prefetch, neither received nor cancelled
+    unsigned m_prefetch_lookahead = 1000;
+    static constexpr unsigned m_camera_history_length = 500; // msecs
+    struct RetryState {
+        unsigned n_failures = 0;
+        uint64_t first_failure = 0;
+        uint64_t last_failure = 0;
+        uint64_t next_attempt = 0;
+        bool attempt_in_flight = false;
+    };
+    std::unordered_map<tile::Id, RetryState, tile::Id::Hasher> m_retries;
+    std::deque<uint64_t> m_retry_times; // for the budget, oldest first
+    unsigned m_retry_backoff_base = 1000;
+    unsigned m_retry_backoff_max = 60 * 1000;
+    unsigned m_retry_budget = 100;
+    unsigned m_retry_budget_period = 10 * 1000;
+    uint64_t m_sum_of_recovery_times = 0;
+    std::mt19937 m_random_engine { std::random_device {}() };
+    std::unique_ptr<QTimer> m_retry_timer;
     utils::AabbDecoratorPtr m_aabb_decorator;
     Cache<tile_types::TileQuad> m_ram_cache;
+    TileAvailability m_availability;
+    QuadTreeCut m_current_cut;
     Cache<tile_types::GpuCacheInfo> m_gpu_cached;
+    std::unordered_set<tile::Id, tile::Id::Hasher> m_gpu_outdated; // on the gpu, but with placeholder textures
+    // quads that arrived since the last gpu update. as long as the camera doesn't change, only they and their subtrees are evaluated.
+    std::unordered_set<tile::Id, tile::Id::Hasher> m_arrived_quads;
+    bool m_full_gpu_update_needed = true;
+    Cache<tile_types::GpuTileQuad> m_decoded_cache;
+    struct GpuUpdate {
+        std::vector<tile_types::GpuTileQuad> quads;
+        std::vector<char> ready;
+        std::vector<char> cacheable; // preliminary quads are not kept in the decoded cache
+        std::vector<tile::Id> deleted_quads;
+        size_t n_sent = 0;
+        size_t n_decoded = 0;
+        bool first_chunk_sent = false;
+    };
+    std::deque<GpuUpdate> m_gpu_updates; // oldest first. updates are sent in order, so quads are never deleted before they were added.
+    uint64_t m_first_gpu_update = 0; // serial number of m_gpu_updates.front()
+    std::unique_ptr<QThreadPool> m_decode_pool;
+    std::unique_ptr<DiskCacheWriter> m_disk_cache_writer; // not a child, lives on m_disk_cache_thread
+    std::unique_ptr<QThread> m_disk_cache_thread;
     std::shared_ptr<QByteArray> m_default_ortho_tile;
     std::shared_ptr<QByteArray> m_default_height_tile;
+    std::shared_ptr<const nucleus::utils::ColourTexture> m_default_ortho_texture;
+    std::shared_ptr<const nucleus::Raster<uint16_t>> m_default_height_raster;
     nucleus::utils::ColourTexture::Format m_ortho_tile_compression_algorithm = nucleus::utils::ColourTexture::Format::Uncompressed_RGBA;
 };
 }
@@ -18,6 +18,8 @@
 
 #include "SlotLimiter.h"
 
+#include <algorithm>
+
 using namespace nucleus::tile_scheduler;
 
 SlotLimiter::SlotLimiter(QObject* parent)
@@ -44,6 +46,17 @@ unsigned SlotLimiter::slots_taken() const
 void SlotLimiter::request_quads(const std::vector<tile::Id>& ids)
 {
     m_request_queue.clear();
+    const std::unordered_set<tile::Id, tile::Id::Hasher> requested(ids.cbegin(), ids.cend());
+    std::vector<tile::Id> stale;
+    for (const tile::Id& id : m_in_flight) {
+        if (!requested.contains(id))
+            stale.push_back(id);
+    }
+    for (const tile::Id& id : stale) {
+        m_in_flight.erase(id);
+        emit quad_cancelled(id);
+    }
+
     for (const tile::Id& id : ids) {
         if (m_in_flight.contains(id))
             continue;
@@ -54,16 +67,18 @@ void SlotLimiter::request_quads(const std::vector<tile::Id>& ids)
             emit quad_requested(id);
         }
     }
+    std::reverse(m_request_queue.begin(), m_request_queue.end());
 }
 
 void SlotLimiter::deliver_quad(const tile_types::TileQuad& tile)
 {
-    m_in_flight.erase(tile.id);
+    const auto was_in_flight = m_in_flight.erase(tile.id) > 0;
     emit quad_delivered(tile);
-    if (m_request_queue.empty())
-        return;
+    if (!was_in_flight || m_request_queue.empty())
+        return; // the slot of a cancelled quad was given away already
 
-    m_in_flight.insert(m_request_queue.front());
-    emit quad_requested(m_request_queue.front());
-    m_request_queue.erase(m_request_queue.cbegin());
+    const auto id = m_request_queue.back();
+    m_request_queue.pop_back();
+    m_in_flight.insert(id);
+    emit quad_requested(id);
 }
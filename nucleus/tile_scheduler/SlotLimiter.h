@@ -33,7 +33,7 @@ class SlotLimiter : public QObject {
 
     unsigned m_limit = 16;
     std::unordered_set<tile::Id, tile::Id::Hasher> m_in_flight;
-    std::vector<tile::Id> m_request_queue;
+    std::vector<tile::Id> m_request_queue; // reversed, the most important request is at the back
 
 public:
     explicit SlotLimiter(QObject* parent = nullptr);
@@ -43,11 +43,14 @@ public:
     unsigned int slots_taken() const;
 
 public slots:
+    /// ids must be ordered by priority, most important first. replaces all queued requests.
+    /// quads in flight that are not in the list anymore are cancelled, and their slots are given to the next requests.
     void request_quads(const std::vector<tile::Id>& id);
     void deliver_quad(const tile_types::TileQuad& tile);
 
 signals:
     void quad_requested(const tile::Id& tile_id);
+    void quad_cancelled(const tile::Id& tile_id);
     void quad_delivered(const tile_types::TileQuad& id);
 };
 
@@ -0,0 +1,122 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "TileAvailability.h"
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+#include <QFile>
+#include <QSaveFile>
+#include <fmt/format.h>
+#include <zpp_bits.h>
+
+#include "utils.h"
+
+using namespace nucleus::tile_scheduler;
+
+namespace {
+struct Entry {
+    unsigned zoom_level;
+    unsigned x;
+    unsigned y;
+    uint64_t expires_at;
+};
+} // namespace
+
+bool TileAvailability::available(const tile::Id& id) const
+{
+    if (m_unavailable.empty())
+        return true;
+    const auto current_time = utils::time_since_epoch();
+    for (auto node = id;; node = node.parent()) {
+        const auto iter = m_unavailable.find(node);
+        if (iter != m_unavailable.end() && iter->second > current_time)
+            return false;
+        if (node.zoom_level == 0)
+            return true;
+    }
+}
+
+void TileAvailability::mark_unavailable(const tile::Id& id, uint64_t expires_at)
+{
+    auto& entry = m_unavailable[id];
+    entry = std::max(entry, expires_at);
+}
+
+void TileAvailability::clear()
+{
+    m_unavailable.clear();
+}
+
+void TileAvailability::prune()
+{
+    const auto current_time = utils::time_since_epoch();
+    std::erase_if(m_unavailable, [current_time](const auto& entry) { return entry.second <= current_time; });
+}
+
+size_t TileAvailability::n_entries() const
+{
+    return m_unavailable.size();
+}
+
+tl::expected<void, std::string> TileAvailability::write_to_disk(const std::filesystem::path& path) const
+{
+    std::vector<Entry> entries;
+    entries.reserve(m_unavailable.size());
+    for (const auto& [id, expires_at] : m_unavailable)
+        entries.push_back({ id.zoom_level, id.coords.x, id.coords.y, expires_at });
+
+    std::vector<char> bytes;
+    zpp::bits::out out(bytes);
+    const auto r = out(version_information, entries);
+    if (failure(r))
+        return tl::unexpected(std::make_error_code(r).message());
+
+    QSaveFile file(QString::fromStdString(path.string()));
+    if (!file.open(QIODeviceBase::WriteOnly))
+        return tl::unexpected<std::string>(fmt::format("Couldn't open file '{}' for writing!", path.string()));
+    file.write(bytes.data(), qint64(bytes.size()));
+    if (!file.commit())
+        return tl::unexpected<std::string>(fmt::format("Couldn't write file '{}'!", path.string()));
+    return {};
+}
+
+tl::expected<void, std::string> TileAvailability::read_from_disk(const std::filesystem::path& path)
+{
+    QFile file(QString::fromStdString(path.string()));
+    if (!file.open(QIODeviceBase::ReadOnly))
+        return tl::unexpected<std::string>(fmt::format("Couldn't open file '{}' for reading!", path.string()));
+    const auto bytes = file.readAll();
+
+    zpp::bits::in in(std::span<const char>(bytes.constData(), size_t(bytes.size())));
+    std::array<char, 25> version = {};
+    std::vector<Entry> entries;
+    if (failure(in(version)))
+        return tl::unexpected<std::string>(fmt::format("File '{}' is not a tile availability file!", path.string()));
+    if (version != version_information)
+        return tl::unexpected<std::string>(fmt::format("File '{}' has an incompatible version!", path.string()));
+    const auto r = in(entries);
+    if (failure(r))
+        return tl::unexpected(std::make_error_code(r).message());
+
+    for (const auto& entry : entries)
+        mark_unavailable(tile::Id { entry.zoom_level, { entry.x, entry.y } }, entry.expires_at);
+    return {};
+}
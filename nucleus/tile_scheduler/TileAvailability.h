@@ -0,0 +1,61 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <filesystem>
+#include <limits>
+#include <unordered_map>
+
+#include <tl/expected.hpp>
+
+#include <radix/tile.h>
+
+namespace nucleus::tile_scheduler {
+
+/// Knows which tiles don't exist in the datasets, so that they are neither refined nor requested.
+/// The datasets are pyramids, i.e., if there is no tile, there are also no descendants. Hence only the roots of unavailable
+/// subtrees are stored, and lookups walk up the (implicit) quad tree.
+/// Entries are either learned from NotFound responses (and expire, so that extensions of the dataset are picked up eventually),
+/// or read from a file (e.g., a metadata file shipped with the dataset, with entries that never expire).
+/// There is one index for both layers: a tile is unavailable if it is missing in the height or the ortho dataset, because it can
+/// only be shown with both.
+class TileAvailability {
+public:
+    static constexpr uint64_t never_expires = std::numeric_limits<uint64_t>::max();
+
+    [[nodiscard]] bool available(const tile::Id& id) const;
+    /// expires_at is in msecs since epoch, compatible with utils::time_since_epoch()
+    void mark_unavailable(const tile::Id& id, uint64_t expires_at = never_expires);
+    void clear();
+    /// drops expired entries
+    void prune();
+    [[nodiscard]] size_t n_entries() const;
+
+    tl::expected<void, std::string> write_to_disk(const std::filesystem::path& path) const;
+    /// entries are added to the existing ones
+    tl::expected<void, std::string> read_from_disk(const std::filesystem::path& path);
+
+    static constexpr std::array<char, 25> version_information = { "TileAvailability, v 0.1" };
+
+private:
+    std::unordered_map<tile::Id, uint64_t, tile::Id::Hasher> m_unavailable; // root of an unavailable subtree -> expiry
+};
+
+} // namespace nucleus::tile_scheduler
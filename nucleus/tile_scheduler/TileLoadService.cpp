@@ -18,18 +18,22 @@
 
 #include "TileLoadService.h"
 
+#include <algorithm>
+
 #include <QDebug>
 #include <QImage>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QtVersionChecks>
-
-#include "../srs.h"
+#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
+#include <QHttp1Configuration>
+#endif
 
 using namespace nucleus::tile_scheduler;
 
 TileLoadService::TileLoadService(const QString& base_url, UrlPattern url_pattern, const QString& file_ending, const LoadBalancingTargets& load_balancing_targets)
-    : m_network_manager(new QNetworkAccessManager(this))
+    : TileSource {}
+    , m_network_manager(new QNetworkAccessManager(this))
     , m_base_url(base_url)
     , m_url_pattern(url_pattern)
     , m_file_ending(file_ending)
@@ -44,17 +48,49 @@ void TileLoadService::load(const tile::Id& tile_id)
     QNetworkRequest request(QUrl(build_tile_url(tile_id)));
     request.setTransferTimeout(int(m_transfer_timeout));
     request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache);
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, m_connection_settings.http2_allowed);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
+    request.setAttribute(QNetworkRequest::Http2CleartextAllowedAttribute, m_connection_settings.http2_cleartext_allowed);
+#endif
 #if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
     request.setAttribute(QNetworkRequest::UseCredentialsAttribute, false);
+    QHttp1Configuration http1_configuration;
+    http1_configuration.setNumberOfConnectionsPerHost(qsizetype(std::max(1u, m_connection_settings.n_connections_per_host)));
+    request.setHttp1Configuration(http1_configuration);
 #endif
 
+    // expired tiles are revalidated, the server answers with 304 and no body if they didn't change.
+    tile_types::CacheValidators validators;
+    if (const auto iter = m_validators.find(tile_id); iter != m_validators.end()) {
+        validators = std::move(iter->second);
+        m_validators.erase(iter);
+        if (!validators.etag.isEmpty())
+            request.setRawHeader("If-None-Match", validators.etag);
+        if (!validators.last_modified.isEmpty())
+            request.setRawHeader("If-Modified-Since", validators.last_modified);
+    }
+
     QNetworkReply* reply = m_network_manager->get(request);
-    connect(reply, &QNetworkReply::finished, [tile_id, reply, this]() {
+    m_replies[tile_id] = reply;
+    connect(reply, &QNetworkReply::finished, [tile_id, reply, validators, this]() {
+        const auto iter = m_replies.find(tile_id);
+        if (iter == m_replies.end() || iter->second != reply) {
+            reply->deleteLater(); // cancelled
+            return;
+        }
+        m_replies.erase(iter);
         const auto error = reply->error();
         const auto timestamp = utils::time_since_epoch();
         if (error == QNetworkReply::NoError) {
-            auto tile = std::make_shared<QByteArray>(reply->readAll());
-            emit load_finished({tile_id, {tile_types::NetworkInfo::Status::Good, timestamp}, tile});
+            auto new_validators = tile_types::CacheValidators { reply->rawHeader("ETag"), reply->rawHeader("Last-Modified") };
+            if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304) {
+                if (new_validators.empty())
+                    new_validators = validators;
+                emit load_finished({tile_id, {tile_types::NetworkInfo::Status::Good, timestamp}, nullptr, new_validators});
+            } else {
+                auto tile = std::make_shared<QByteArray>(reply->readAll());
+                emit load_finished({tile_id, {tile_types::NetworkInfo::Status::Good, timestamp}, tile, new_validators});
+            }
         } else if (error == QNetworkReply::ContentNotFoundError) {
             auto tile = std::make_shared<QByteArray>();
             emit load_finished({tile_id, {tile_types::NetworkInfo::Status::NotFound, timestamp}, tile});
@@ -67,24 +103,25 @@ void TileLoadService::load(const tile::Id& tile_id)
     });
 }
 
+void TileLoadService::cancel(const tile::Id& tile_id)
+{
+    m_validators.erase(tile_id);
+    const auto iter = m_replies.find(tile_id);
+    if (iter == m_replies.end())
+        return;
+    QNetworkReply* reply = iter->second;
+    m_replies.erase(iter); // before aborting, as that emits finished
+    reply->abort();
+}
+
+void TileLoadService::set_validators(const tile::Id& tile_id, const tile_types::CacheValidators& validators)
+{
+    m_validators[tile_id] = validators;
+}
+
 QString TileLoadService::build_tile_url(const tile::Id& tile_id) const
 {
-    QString tile_address;
-    const auto n_y_tiles = srs::number_of_vertical_tiles_for_zoom_level(tile_id.zoom_level);
-    switch (m_url_pattern) {
-    case UrlPattern::ZXY:
-        tile_address = QString("%1/%2/%3").arg(tile_id.zoom_level).arg(tile_id.coords.x).arg(tile_id.coords.y);
-        break;
-    case UrlPattern::ZYX:
-        tile_address = QString("%1/%3/%2").arg(tile_id.zoom_level).arg(tile_id.coords.x).arg(tile_id.coords.y);
-        break;
-    case UrlPattern::ZXY_yPointingSouth:
-        tile_address = QString("%1/%2/%3").arg(tile_id.zoom_level).arg(tile_id.coords.x).arg(n_y_tiles - tile_id.coords.y - 1);
-        break;
-    case UrlPattern::ZYX_yPointingSouth:
-        tile_address = QString("%1/%3/%2").arg(tile_id.zoom_level).arg(tile_id.coords.x).arg(n_y_tiles - tile_id.coords.y - 1);
-        break;
-    }
+    const auto tile_address = TileSource::tile_address(tile_id, m_url_pattern);
     if (!m_load_balancing_targets.empty()) {
         const unsigned hash = qHash(tile_address) % 1024;
         const auto index = unsigned((float(hash) / 1024.1f) * float(m_load_balancing_targets.size()));
@@ -104,3 +141,21 @@ void TileLoadService::set_transfer_timeout(unsigned int new_transfer_timeout)
     assert(new_transfer_timeout < unsigned(std::numeric_limits<int>::max()));
     m_transfer_timeout = new_transfer_timeout;
 }
+
+const TileLoadService::ConnectionSettings& TileLoadService::connection_settings() const
+{
+    return m_connection_settings;
+}
+
+void TileLoadService::set_connection_settings(const ConnectionSettings& new_connection_settings)
+{
+    m_connection_settings = new_connection_settings;
+}
+
+void TileLoadService::set_network_manager(std::shared_ptr<QNetworkAccessManager> network_manager)
+{
+    assert(network_manager);
+    assert(network_manager->thread() == thread());
+    assert(m_replies.empty()); // replies are owned by the manager
+    m_network_manager = std::move(network_manager);
+}
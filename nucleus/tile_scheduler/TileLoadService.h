@@ -19,26 +19,27 @@
 #pragma once
 
 #include <memory>
+#include <unordered_map>
 
-#include <QObject>
-
+#include "TileSource.h"
 #include "constants.h"
-#include "tile_types.h"
 
 class QNetworkAccessManager;
+class QNetworkReply;
 
 namespace nucleus::tile_scheduler {
 
-class TileLoadService : public QObject {
+// loads tiles via http(s)
+class TileLoadService : public TileSource {
     Q_OBJECT
 public:
-    enum class UrlPattern {
-        ZXY,
-        ZYX, // y=0 is southern most tile
-        ZXY_yPointingSouth,
-        ZYX_yPointingSouth // y=0 is the northern most tile
-    };
     using LoadBalancingTargets = std::vector<QString>;
+    // http/2 multiplexes all requests to a host over a single connection, n_connections_per_host applies to http/1.1 only.
+    struct ConnectionSettings {
+        bool http2_allowed = true;
+        bool http2_cleartext_allowed = false; // h2c with prior knowledge, the server must support it. requires qt 6.3
+        unsigned n_connections_per_host = 6; // requires qt 6.5, otherwise qt's default (6) is used
+    };
 
     TileLoadService(const QString& base_url, UrlPattern url_pattern, const QString& file_ending, const LoadBalancingTargets& load_balancing_targets = {});
     ~TileLoadService() override;
@@ -47,18 +48,28 @@ public:
     [[nodiscard]] unsigned int transfer_timeout() const;
     void set_transfer_timeout(unsigned int new_transfer_timeout);
 
-public slots:
-    void load(const tile::Id& tile_id);
+    [[nodiscard]] const ConnectionSettings& connection_settings() const;
+    void set_connection_settings(const ConnectionSettings& new_connection_settings);
+
+    /// allows several services to share one connection pool. the manager must live on the same thread as the service.
+    void set_network_manager(std::shared_ptr<QNetworkAccessManager> network_manager);
 
-signals:
-    void load_finished(tile_types::TileLayer tile);
+public slots:
+    void load(const tile::Id& tile_id) override;
+    /// aborts the transfer
+    void cancel(const tile::Id& tile_id) override;
+    /// the next load of tile_id is conditional (If-None-Match / If-Modified-Since). on 304, the tile is reported without data.
+    void set_validators(const tile::Id& tile_id, const tile_types::CacheValidators& validators) override;
 
 private:
     unsigned m_transfer_timeout = tile_scheduler::constants::default_network_timeout;
+    ConnectionSettings m_connection_settings;
     std::shared_ptr<QNetworkAccessManager> m_network_manager;
     QString m_base_url;
     UrlPattern m_url_pattern;
     QString m_file_ending;
     LoadBalancingTargets m_load_balancing_targets;
+    std::unordered_map<tile::Id, QNetworkReply*, tile::Id::Hasher> m_replies;
+    std::unordered_map<tile::Id, tile_types::CacheValidators, tile::Id::Hasher> m_validators; // consumed by load
 };
 }
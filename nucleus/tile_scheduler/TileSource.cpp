@@ -0,0 +1,49 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "TileSource.h"
+
+#include "../srs.h"
+
+using namespace nucleus::tile_scheduler;
+
+TileSource::TileSource(QObject* parent)
+    : QObject { parent }
+{
+}
+
+TileSource::~TileSource() = default;
+
+void TileSource::set_validators(const tile::Id&, const tile_types::CacheValidators&) { }
+
+QString TileSource::tile_address(const tile::Id& tile_id, UrlPattern url_pattern)
+{
+    const auto n_y_tiles = srs::number_of_vertical_tiles_for_zoom_level(tile_id.zoom_level);
+    switch (url_pattern) {
+    case UrlPattern::ZXY:
+        return QString("%1/%2/%3").arg(tile_id.zoom_level).arg(tile_id.coords.x).arg(tile_id.coords.y);
+    case UrlPattern::ZYX:
+        return QString("%1/%3/%2").arg(tile_id.zoom_level).arg(tile_id.coords.x).arg(tile_id.coords.y);
+    case UrlPattern::ZXY_yPointingSouth:
+        return QString("%1/%2/%3").arg(tile_id.zoom_level).arg(tile_id.coords.x).arg(n_y_tiles - tile_id.coords.y - 1);
+    case UrlPattern::ZYX_yPointingSouth:
+        return QString("%1/%3/%2").arg(tile_id.zoom_level).arg(tile_id.coords.x).arg(n_y_tiles - tile_id.coords.y - 1);
+    }
+    assert(false);
+    return {};
+}
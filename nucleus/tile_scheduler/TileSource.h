@@ -0,0 +1,52 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include <QObject>
+
+#include "tile_types.h"
+
+namespace nucleus::tile_scheduler {
+
+class TileSource : public QObject {
+    Q_OBJECT
+public:
+    enum class UrlPattern {
+        ZXY,
+        ZYX, // y=0 is southern most tile
+        ZXY_yPointingSouth,
+        ZYX_yPointingSouth // y=0 is the northern most tile
+    };
+
+    explicit TileSource(QObject* parent = nullptr);
+    ~TileSource() override;
+    /// e.g., "12/2208/1365", without base url and file ending
+    [[nodiscard]] static QString tile_address(const tile::Id& tile_id, UrlPattern url_pattern);
+
+public slots:
+    virtual void load(const tile::Id& tile_id) = 0;
+    /// load_finished is not emitted for cancelled tiles.
+    virtual void cancel(const tile::Id& tile_id) = 0;
+    /// validators of the cached tile, to be used by the next load of tile_id. sources that can't make conditional requests ignore them.
+    virtual void set_validators(const tile::Id& tile_id, const tile_types::CacheValidators& validators);
+
+signals:
+    void load_finished(tile_types::TileLayer tile);
+};
+}
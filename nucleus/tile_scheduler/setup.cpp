@@ -0,0 +1,69 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "setup.h"
+
+#include "LayerAssembler.h"
+#include "QuadAssembler.h"
+#include "RateLimiter.h"
+#include "Scheduler.h"
+#include "SlotLimiter.h"
+#include "TileSource.h"
+
+namespace nucleus::tile_scheduler::setup {
+
+Pipeline connect_pipeline(Scheduler* scheduler, TileSource* ortho_source, TileSource* height_source)
+{
+    auto* sch = scheduler;
+    SlotLimiter* sl = new SlotLimiter(sch);
+    RateLimiter* rl = new RateLimiter(sch);
+    rl->set_adaptive(true);
+    QuadAssembler* qa = new QuadAssembler(sch);
+    LayerAssembler* la = new LayerAssembler(sch);
+    QObject::connect(sch, &Scheduler::quads_requested, sl, &SlotLimiter::request_quads);
+    QObject::connect(sl, &SlotLimiter::quad_requested, rl, &RateLimiter::request_quad);
+    QObject::connect(rl, &RateLimiter::quad_requested, qa, &QuadAssembler::load);
+    QObject::connect(qa, &QuadAssembler::tile_requested, la, &LayerAssembler::load);
+    QObject::connect(la, &LayerAssembler::tile_requested, ortho_source, &TileSource::load);
+    QObject::connect(la, &LayerAssembler::tile_requested, height_source, &TileSource::load);
+
+    // expired tiles are requested conditionally, the sources need to know their validators
+    QObject::connect(sch, &Scheduler::revalidation_requested, la, &LayerAssembler::revalidate);
+    QObject::connect(la, &LayerAssembler::ortho_validators_announced, ortho_source, &TileSource::set_validators);
+    QObject::connect(la, &LayerAssembler::height_validators_announced, height_source, &TileSource::set_validators);
+
+    // requests for quads that lost relevance are aborted, so that their slots are free again right away
+    QObject::connect(sl, &SlotLimiter::quad_cancelled, rl, &RateLimiter::cancel_quad);
+    QObject::connect(rl, &RateLimiter::quad_cancelled, qa, &QuadAssembler::cancel);
+    QObject::connect(qa, &QuadAssembler::tile_cancelled, la, &LayerAssembler::cancel);
+    QObject::connect(la, &LayerAssembler::tile_cancelled, ortho_source, &TileSource::cancel);
+    QObject::connect(la, &LayerAssembler::tile_cancelled, height_source, &TileSource::cancel);
+    QObject::connect(sl, &SlotLimiter::quad_cancelled, sch, &Scheduler::receive_cancellation);
+
+    QObject::connect(ortho_source, &TileSource::load_finished, la, &LayerAssembler::deliver_ortho);
+    QObject::connect(height_source, &TileSource::load_finished, la, &LayerAssembler::deliver_height);
+    QObject::connect(la, &LayerAssembler::tile_loaded, qa, &QuadAssembler::deliver_tile);
+    // geometry is shown before the (slower) ortho photos arrive. the request stays in its slot until the quad is complete.
+    QObject::connect(la, &LayerAssembler::preliminary_tile_loaded, qa, &QuadAssembler::deliver_preliminary_tile);
+    QObject::connect(qa, &QuadAssembler::preliminary_quad_loaded, sch, &Scheduler::receive_preliminary_quad);
+    QObject::connect(qa, &QuadAssembler::quad_loaded, sl, &SlotLimiter::deliver_quad);
+    QObject::connect(qa, &QuadAssembler::quad_loaded, rl, &RateLimiter::receive_quad);
+    QObject::connect(sl, &SlotLimiter::quad_delivered, sch, &Scheduler::receive_quad);
+    return { sl, rl, qa, la };
+}
+}
@@ -0,0 +1,41 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+namespace nucleus::tile_scheduler {
+class Scheduler;
+class TileSource;
+class SlotLimiter;
+class RateLimiter;
+class QuadAssembler;
+class LayerAssembler;
+}
+
+namespace nucleus::tile_scheduler::setup {
+
+struct Pipeline {
+    SlotLimiter* slot_limiter;
+    RateLimiter* rate_limiter;
+    QuadAssembler* quad_assembler;
+    LayerAssembler* layer_assembler;
+};
+
+/// creates the chain from the scheduler's quad requests to the tile sources and back. the parts are children of the scheduler.
+Pipeline connect_pipeline(Scheduler* scheduler, TileSource* ortho_source, TileSource* height_source);
+}
@@ -0,0 +1,38 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "tile_types.h"
+
+#include "nucleus/Raster.h"
+
+namespace nucleus::tile_scheduler::tile_types {
+
+size_t GpuTileQuad::size_in_bytes() const
+{
+    // textures shared between quads (e.g., default tiles) are counted for each of them.
+    size_t size = sizeof(GpuTileQuad);
+    for (const auto& tile : tiles) {
+        if (tile.ortho)
+            size += sizeof(nucleus::utils::ColourTexture) + tile.ortho->n_bytes();
+        if (tile.height)
+            size += sizeof(nucleus::Raster<uint16_t>) + tile.height->buffer_length() * sizeof(uint16_t);
+    }
+    return size;
+}
+
+} // namespace nucleus::tile_scheduler::tile_types
@@ -68,18 +68,54 @@ concept SerialisableTile = requires(T t) {
     requires std::is_same<std::remove_reference_t<decltype(T::version_information)>, const std::array<char, 25>>::value;
 };
 
+/// tiles implementing this are accounted by their actual memory footprint (including sizeof) in caches.
+template <typename T>
+concept SizedTile = requires(const T& t) {
+    {
+        t.size_in_bytes()
+    } -> utils::convertible_to<size_t>;
+};
+
+inline size_t size_in_bytes(const std::shared_ptr<QByteArray>& data)
+{
+    if (!data)
+        return 0;
+    // control block of the shared pointer, the byte array and its heap header (estimated)
+    return 2 * sizeof(void*) + sizeof(QByteArray) + 2 * sizeof(void*) + size_t(data->capacity());
+}
+
+/// http cache validators of a downloaded tile. once the tile expired, they are sent with a conditional request,
+/// so that the server can answer with 304 (not modified) instead of the whole tile.
+struct CacheValidators {
+    QByteArray etag;
+    QByteArray last_modified;
+    bool empty() const { return etag.isEmpty() && last_modified.isEmpty(); }
+    size_t size_in_bytes() const { return size_t(etag.capacity() + last_modified.capacity()); }
+};
+
+/// validators of an expired tile, announced to the tile sources before the tile is requested again.
+struct TileValidators {
+    tile::Id id;
+    CacheValidators ortho;
+    CacheValidators height;
+};
+static_assert(NamedTile<TileValidators>);
+
 struct TileLayer {
     tile::Id id;
     NetworkInfo network_info;
-    std::shared_ptr<QByteArray> data;
+    std::shared_ptr<QByteArray> data; // null if the server confirmed that the cached data is still valid (status is Good then)
+    CacheValidators validators = {};
 };
 static_assert(NamedTile<TileLayer>);
 
 struct LayeredTile {
     tile::Id id;
     NetworkInfo network_info;
-    std::shared_ptr<QByteArray> ortho;
+    std::shared_ptr<QByteArray> ortho; // null if unchanged, see TileLayer::data. the scheduler fills it in from the cache.
     std::shared_ptr<QByteArray> height;
+    CacheValidators ortho_validators = {};
+    CacheValidators height_validators = {};
 };
 static_assert(NamedTile<LayeredTile>);
 
@@ -87,13 +123,24 @@ struct TileQuad {
     tile::Id id;
     unsigned n_tiles = 0;
     std::array<LayeredTile, 4> tiles = {};
+    bool preliminary = false; // heights only, the ortho photos are still loading. persisted, so that they are replaced after a restart.
     NetworkInfo network_info() const {
         return NetworkInfo::join(tiles[0].network_info, tiles[1].network_info, tiles[2].network_info, tiles[3].network_info);
     }
-    static constexpr std::array<char, 25> version_information = {"TileQuad, version 0.3"};
+    size_t size_in_bytes() const
+    {
+        size_t size = sizeof(TileQuad);
+        for (const auto& tile : tiles) {
+            size += tile_types::size_in_bytes(tile.ortho) + tile_types::size_in_bytes(tile.height);
+            size += tile.ortho_validators.size_in_bytes() + tile.height_validators.size_in_bytes();
+        }
+        return size;
+    }
+    static constexpr std::array<char, 25> version_information = {"TileQuad, version 0.5"};
 };
 static_assert(NamedTile<TileQuad>);
 static_assert(SerialisableTile<TileQuad>);
+static_assert(SizedTile<TileQuad>);
 
 struct GpuCacheInfo {
     tile::Id id;
@@ -111,7 +158,12 @@ static_assert(NamedTile<GpuLayeredTile>);
 struct GpuTileQuad {
     tile::Id id;
     std::array<GpuLayeredTile, 4> tiles;
+    uint64_t source_timestamp = 0; // network timestamp of the TileQuad it was decoded from
+    size_t size_in_bytes() const;
+    static constexpr std::array<char, 25> version_information = {"GpuTileQuad, version 0.1"};
 };
 static_assert(NamedTile<GpuTileQuad>);
+static_assert(SerialisableTile<GpuTileQuad>);
+static_assert(SizedTile<GpuTileQuad>);
 
 } // namespace nucleus::tile_scheduler::tile_types
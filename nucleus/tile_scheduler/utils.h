@@ -22,6 +22,13 @@
 #include <concepts>
 #endif
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <limits>
+#include <span>
+#include <vector>
+
 #include <QByteArray>
 
 #include "constants.h"
@@ -240,6 +247,176 @@ namespace utils {
         return true;
     }
 
+    /// camera_frustum_contains_tile for many tiles, e.g., the four children of a tile or a whole level of the tree, with identical
+    /// results. everything that depends only on the frustum (the separating axes and the extent of the frustum along them) is
+    /// computed once. the tiles are tested in lanes of a structure of arrays, which the compiler vectorises (sse2, neon, wasm simd).
+    /// it stays in double precision, camera relative floats would change the results.
+    class FrustumCuller {
+    public:
+        static constexpr unsigned n_lanes = 4;
+
+        explicit FrustumCuller(const nucleus::camera::Frustum& frustum)
+            : m_frustum(frustum)
+        {
+            const auto add_axis = [this](const glm::dvec3& direction) {
+                Axis axis { direction, std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest() };
+                for (const auto& c : m_frustum.corners) {
+                    const auto p = glm::dot(c, direction);
+                    if (p < axis.frustum_min)
+                        axis.frustum_min = p;
+                    if (p > axis.frustum_max)
+                        axis.frustum_max = p;
+                }
+                m_axes[m_n_axes++] = axis;
+            };
+            // same axes as in camera_frustum_contains_tile
+            const auto frustum_edges = std::array {
+                glm::normalize(frustum.corners[4] - frustum.corners[0]),
+                glm::normalize(frustum.corners[5] - frustum.corners[1]),
+                glm::normalize(frustum.corners[6] - frustum.corners[2]),
+                glm::normalize(frustum.corners[7] - frustum.corners[3]),
+                glm::normalize(frustum.corners[1] - frustum.corners[0]),
+                glm::normalize(frustum.corners[3] - frustum.corners[0])
+            };
+            constexpr auto aabb_edges = std::array { glm::dvec3 { 1., 0., 0. }, glm::dvec3 { 0., 1., 0. }, glm::dvec3 { 0., 0., 1. } };
+            for (const auto& direction : aabb_edges)
+                add_axis(direction);
+            for (const auto& fe : frustum_edges) {
+                for (const auto& ae : aabb_edges) {
+                    const glm::dvec3 direction = glm::cross(fe, ae);
+                    if (std::abs(direction.x) < geometry::epsilon<double>
+                        && std::abs(direction.y) < geometry::epsilon<double>
+                        && std::abs(direction.z) < geometry::epsilon<double>)
+                        continue; // parallel
+                    add_axis(direction);
+                }
+            }
+        }
+
+        /// a single tile takes the scalar path with the early exits of camera_frustum_contains_tile, most tiles are decided by the
+        /// clipping planes already. filling lanes would only pay for the full test of three empty ones.
+        [[nodiscard]] bool contains(const tile::SrsAndHeightBounds& aabb) const
+        {
+            const auto corner_in_direction = [&aabb](const glm::dvec3& direction) {
+                return glm::dvec3 { direction.x > 0 ? aabb.max.x : aabb.min.x, direction.y > 0 ? aabb.max.y : aabb.min.y, direction.z > 0 ? aabb.max.z : aabb.min.z };
+            };
+            bool all_inside = true;
+            for (const auto& p : m_frustum.clipping_planes) {
+                if (distance(p, corner_in_direction(p.normal)) <= 0)
+                    return false;
+                all_inside = all_inside && (distance(p, corner_in_direction(-p.normal)) > 0);
+            }
+            if (all_inside || corner_inside(aabb))
+                return true;
+            for (unsigned i = 0; i < m_n_axes; ++i) {
+                const auto& axis = m_axes[i];
+                const auto a = glm::dot(corner_in_direction(axis.direction), axis.direction);
+                const auto b = glm::dot(corner_in_direction(-axis.direction), axis.direction);
+                if (!(std::min(a, b) <= axis.frustum_max && axis.frustum_min <= std::max(a, b)))
+                    return false;
+            }
+            return true;
+        }
+
+        [[nodiscard]] std::array<bool, n_lanes> contains(const std::array<tile::SrsAndHeightBounds, n_lanes>& aabbs) const
+        {
+            return contains_lanes(aabbs);
+        }
+
+        [[nodiscard]] std::vector<bool> contains(const std::vector<tile::SrsAndHeightBounds>& aabbs) const
+        {
+            std::vector<bool> results(aabbs.size());
+            for (size_t i = 0; i < aabbs.size(); i += n_lanes) {
+                const auto n = std::min(size_t(n_lanes), aabbs.size() - i);
+                const auto lanes = contains_lanes({ aabbs.data() + i, n });
+                for (size_t j = 0; j < n; ++j)
+                    results[i + j] = lanes[j];
+            }
+            return results;
+        }
+
+    private:
+        struct Axis {
+            glm::dvec3 direction;
+            double frustum_min;
+            double frustum_max;
+        };
+
+        [[nodiscard]] std::array<bool, n_lanes> contains_lanes(std::span<const tile::SrsAndHeightBounds> aabbs) const
+        {
+            assert(!aabbs.empty() && aabbs.size() <= n_lanes);
+            using Lanes = std::array<double, n_lanes>;
+            Lanes min_x, min_y, min_z, max_x, max_y, max_z;
+            for (unsigned l = 0; l < n_lanes; ++l) {
+                const auto& aabb = aabbs[std::min(size_t(l), aabbs.size() - 1)]; // unused lanes repeat the last aabb
+                min_x[l] = aabb.min.x;
+                min_y[l] = aabb.min.y;
+                min_z[l] = aabb.min.z;
+                max_x[l] = aabb.max.x;
+                max_y[l] = aabb.max.y;
+                max_z[l] = aabb.max.z;
+            }
+
+            // the corners of the aabbs in (and against) a direction are the same for all lanes. the lanes are combined with bitwise
+            // operators, && and || would branch per lane and keep the loops from being vectorised. the plane distance and the
+            // projections are spelled out like geometry::distance and glm::dot, so that they are rounded the same way.
+            std::array<bool, n_lanes> outside = {};
+            std::array<bool, n_lanes> all_inside = { true, true, true, true };
+            for (const auto& p : m_frustum.clipping_planes) {
+                const auto& n = p.normal;
+                const auto& far_x = n.x > 0 ? max_x : min_x;
+                const auto& far_y = n.y > 0 ? max_y : min_y;
+                const auto& far_z = n.z > 0 ? max_z : min_z;
+                const auto& near_x = -n.x > 0 ? max_x : min_x;
+                const auto& near_y = -n.y > 0 ? max_y : min_y;
+                const auto& near_z = -n.z > 0 ? max_z : min_z;
+                for (unsigned l = 0; l < n_lanes; ++l) {
+                    const auto far_distance = n.x * far_x[l] + n.y * far_y[l] + n.z * far_z[l] + p.distance;
+                    const auto near_distance = n.x * near_x[l] + n.y * near_y[l] + n.z * near_z[l] + p.distance;
+                    outside[l] = outside[l] | (far_distance <= 0);
+                    all_inside[l] = all_inside[l] & (near_distance > 0);
+                }
+            }
+
+            // separating axes
+            std::array<bool, n_lanes> separated = {};
+            for (unsigned i = 0; i < m_n_axes; ++i) {
+                const auto& axis = m_axes[i];
+                const auto& d = axis.direction;
+                const auto& a_x = d.x > 0 ? max_x : min_x;
+                const auto& a_y = d.y > 0 ? max_y : min_y;
+                const auto& a_z = d.z > 0 ? max_z : min_z;
+                const auto& b_x = -d.x > 0 ? max_x : min_x;
+                const auto& b_y = -d.y > 0 ? max_y : min_y;
+                const auto& b_z = -d.z > 0 ? max_z : min_z;
+                for (unsigned l = 0; l < n_lanes; ++l) {
+                    const auto a = a_x[l] * d.x + a_y[l] * d.y + a_z[l] * d.z;
+                    const auto b = b_x[l] * d.x + b_y[l] * d.y + b_z[l] * d.z;
+                    const auto overlap = (std::min(a, b) <= axis.frustum_max) & (axis.frustum_min <= std::max(a, b));
+                    separated[l] = separated[l] | !overlap;
+                }
+            }
+
+            // only tiles that straddle a plane and have a separating axis need the corner test, which is rare
+            std::array<bool, n_lanes> results = {};
+            for (unsigned l = 0; l < aabbs.size(); ++l) {
+                results[l] = !outside[l] & (all_inside[l] | !separated[l]);
+                if (!outside[l] && !results[l])
+                    results[l] = corner_inside(aabbs[l]);
+            }
+            return results;
+        }
+
+        [[nodiscard]] bool corner_inside(const tile::SrsAndHeightBounds& aabb) const
+        {
+            return std::any_of(m_frustum.corners.cbegin(), m_frustum.corners.cend(), [&](const glm::dvec3& c) { return aabb.contains(c); });
+        }
+
+        nucleus::camera::Frustum m_frustum;
+        std::array<Axis, 21> m_axes = {};
+        unsigned m_n_axes = 0;
+    };
+
     inline auto refine_functor_float(const nucleus::camera::Definition &camera,
                                      const AabbDecoratorPtr &aabb_decorator,
                                      float error_threshold_px,
@@ -289,6 +466,34 @@ namespace utils {
         return refine;
     }
 
+    /// requests are ordered by this key. coarse quads go first, within a zoom level the ones with a larger screen space error,
+    /// and then the closer ones.
+    struct RequestPriority {
+        unsigned zoom_level = 0;
+        float screen_space_error = 0;
+        float distance = 0;
+        bool operator<(const RequestPriority& other) const
+        {
+            if (zoom_level != other.zoom_level)
+                return zoom_level < other.zoom_level;
+            if (screen_space_error != other.screen_space_error)
+                return screen_space_error > other.screen_space_error;
+            return distance < other.distance;
+        }
+    };
+
+    inline auto request_priority_functor(const nucleus::camera::Definition& camera, const AabbDecoratorPtr& aabb_decorator, double tile_size = 256)
+    {
+        constexpr auto sqrt2 = 1.414213562373095;
+        return [&camera, tile_size, aabb_decorator](const tile::Id& tile) {
+            // same error metric as refineFunctor
+            const auto aabb = aabb_decorator->aabb(tile);
+            const auto distance = float(geometry::distance(aabb, camera.position()));
+            const auto pixel_size = float(sqrt2 * aabb.size().x / tile_size);
+            return RequestPriority { tile.zoom_level, camera.to_screen_space(pixel_size, distance), distance };
+        };
+    }
+
     inline uint64_t time_since_epoch()
     {
         return uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
@@ -21,6 +21,8 @@
 #include <QImage>
 #include <vector>
 
+#include <zpp_bits.h>
+
 namespace nucleus::utils {
 
 class ColourTexture {
@@ -34,6 +36,11 @@ private:
     Format m_format = Format::Uncompressed_RGBA;
 
 public:
+    // the compressed blocks are serialised as they are, so that no decoding is necessary when reading them from disk.
+    friend zpp::bits::access;
+    using serialize = zpp::bits::members<4>;
+
+    ColourTexture() = default;
     explicit ColourTexture(const QImage& image, Format format);
     [[nodiscard]] const uint8_t* data() const { return m_data.data(); }
     [[nodiscard]] size_t n_bytes() const { return m_data.size(); }
@@ -0,0 +1,136 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "MockTileServer.h"
+
+#include <algorithm>
+
+#include <QTcpSocket>
+#include <QTimer>
+
+#include "nucleus/tile_scheduler/utils.h"
+
+using namespace unittests;
+
+MockTileServer::MockTileServer(QByteArray payload, unsigned latency_msecs)
+    : MockTileServer(Settings { .latency = latency_msecs }, std::move(payload))
+{
+}
+
+MockTileServer::MockTileServer(const Settings& settings, QByteArray payload)
+    : m_settings(settings)
+    , m_payload(std::move(payload))
+    , m_random_engine(42) // reproducible errors and jitter
+{
+    connect(&m_server, &QTcpServer::newConnection, this, &MockTileServer::accept_connections);
+    const auto listening = m_server.listen(QHostAddress::LocalHost);
+    assert(listening);
+    Q_UNUSED(listening);
+}
+
+QString MockTileServer::base_url() const
+{
+    return QString("http://127.0.0.1:%1/").arg(m_server.serverPort());
+}
+
+void MockTileServer::set_payload(const QByteArray& file_ending, const QByteArray& payload)
+{
+    m_payload_by_file_ending.emplace_back(file_ending, payload);
+}
+
+void MockTileServer::accept_connections()
+{
+    while (QTcpSocket* socket = m_server.nextPendingConnection()) {
+        ++m_n_connections;
+        m_max_open_connections = std::max(m_max_open_connections, ++m_n_open_connections);
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            --m_n_open_connections;
+            socket->deleteLater();
+        });
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+            // requests carry no body, hence the end of the header is the end of the request
+            auto buffer = socket->property("buffer").toByteArray() + socket->readAll();
+            for (auto end = buffer.indexOf("\r\n\r\n"); end >= 0; end = buffer.indexOf("\r\n\r\n")) {
+                const auto header = buffer.left(end);
+                const auto request_line = header.left(header.indexOf("\r\n")).split(' ');
+                buffer.remove(0, end + 4);
+                ++m_n_requests;
+                const auto response = response_for(request_line.size() > 1 ? request_line[1] : QByteArray(), header_value(header, "if-none-match"));
+                QTimer::singleShot(response_delay(response.size()), Qt::PreciseTimer, socket, [socket, response]() { socket->write(response); });
+            }
+            socket->setProperty("buffer", buffer);
+        });
+    }
+}
+
+QByteArray MockTileServer::header_value(const QByteArray& header, const QByteArray& name)
+{
+    for (const auto& line : header.split('\n')) {
+        const auto colon = line.indexOf(':');
+        if (colon > 0 && line.left(colon).trimmed().toLower() == name)
+            return line.mid(colon + 1).trimmed();
+    }
+    return {};
+}
+
+QByteArray MockTileServer::response_for(const QByteArray& path, const QByteArray& if_none_match)
+{
+    const auto roll = std::uniform_real_distribution<float>(0, 1)(m_random_engine);
+    QByteArray status = "200 OK";
+    QByteArray body = m_payload;
+    if (roll < m_settings.error_rate) {
+        status = "500 Internal Server Error";
+        body = {};
+    } else if (roll < m_settings.error_rate + m_settings.not_found_rate) {
+        status = "404 Not Found";
+        body = {};
+    } else {
+        for (const auto& [file_ending, payload] : m_payload_by_file_ending) {
+            if (path.endsWith(file_ending))
+                body = payload;
+        }
+    }
+    QByteArray etag;
+    if (status == "200 OK") {
+        // the payloads never change, hence the etag only depends on the content
+        etag = '"' + QByteArray::number(qHash(body), 16) + '"';
+        if (etag == if_none_match) {
+            ++m_n_not_modified;
+            status = "304 Not Modified";
+            body = {};
+        }
+        etag = "\r\nETag: " + etag;
+    }
+    return "HTTP/1.1 " + status + "\r\nContent-Type: application/octet-stream\r\nContent-Length: " + QByteArray::number(body.size()) + etag
+        + "\r\nConnection: keep-alive\r\n\r\n" + body;
+}
+
+int MockTileServer::response_delay(qsizetype response_size)
+{
+    const auto now = int64_t(nucleus::tile_scheduler::utils::time_since_epoch());
+    auto ready_at = now + m_settings.latency;
+    if (m_settings.jitter > 0)
+        ready_at += std::uniform_int_distribution<unsigned>(0, m_settings.jitter)(m_random_engine);
+    if (m_settings.bandwidth == 0)
+        return int(ready_at - now);
+
+    // responses queue up on a single simulated link
+    const auto transfer_time = int64_t(response_size) * 1000 / m_settings.bandwidth;
+    m_link_free_at = std::max(m_link_free_at, ready_at) + transfer_time;
+    return int(m_link_free_at - now);
+}
@@ -0,0 +1,75 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include <random>
+
+#include <QByteArray>
+#include <QObject>
+#include <QTcpServer>
+
+namespace unittests {
+
+// minimal http/1.1 server on localhost, simulating a tile server. keep-alive is supported, so that connection reuse in the client can be measured.
+// there is no http/2 (neither tls with alpn nor h2c), tests against it can only measure http/1.1 behaviour.
+// responses carry an etag, conditional requests (If-None-Match) for unchanged payloads are answered with 304.
+class MockTileServer : public QObject {
+    Q_OBJECT
+public:
+    struct Settings {
+        unsigned latency = 0; // msecs until the response starts
+        unsigned jitter = 0; // msecs, uniformly distributed on top of the latency
+        unsigned bandwidth = 0; // bytes per second, shared by all connections. 0 is unlimited
+        float not_found_rate = 0; // share of requests answered with 404
+        float error_rate = 0; // share of requests answered with 500
+    };
+
+private:
+    QTcpServer m_server;
+    Settings m_settings;
+    QByteArray m_payload;
+    std::vector<std::pair<QByteArray, QByteArray>> m_payload_by_file_ending;
+    std::mt19937 m_random_engine;
+    int64_t m_link_free_at = 0;
+    unsigned m_n_requests = 0;
+    unsigned m_n_not_modified = 0;
+    unsigned m_n_connections = 0;
+    unsigned m_n_open_connections = 0;
+    unsigned m_max_open_connections = 0;
+
+public:
+    explicit MockTileServer(QByteArray payload, unsigned latency_msecs = 0);
+    MockTileServer(const Settings& settings, QByteArray payload);
+    [[nodiscard]] QString base_url() const;
+    /// requests for paths with this ending are answered with the given payload instead of the default one
+    void set_payload(const QByteArray& file_ending, const QByteArray& payload);
+    [[nodiscard]] unsigned n_requests() const { return m_n_requests; }
+    [[nodiscard]] unsigned n_not_modified() const { return m_n_not_modified; }
+    [[nodiscard]] unsigned n_connections() const { return m_n_connections; }
+    [[nodiscard]] unsigned max_open_connections() const { return m_max_open_connections; }
+
+private slots:
+    void accept_connections();
+
+private:
+    [[nodiscard]] static QByteArray header_value(const QByteArray& header, const QByteArray& name);
+    [[nodiscard]] QByteArray response_for(const QByteArray& path, const QByteArray& if_none_match);
+    [[nodiscard]] int response_delay(qsizetype response_size);
+};
+}
@@ -16,9 +16,12 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *****************************************************************************/
 
-#include <unordered_set>
+#include <atomic>
 #include <sstream>
+#include <thread>
+#include <unordered_set>
 
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
 #include <QStandardPaths>
 #include <QThread>
@@ -32,6 +35,12 @@ struct TestTile {
     tile::Id id;
     std::string data;
 };
+struct SizedTestTile {
+    tile::Id id;
+    std::string data;
+    size_t size_in_bytes() const { return sizeof(SizedTestTile) + data.size(); }
+};
+static_assert(nucleus::tile_scheduler::tile_types::SizedTile<SizedTestTile>);
 struct DiskWriteTestTileInner {
     tile::Id id;
     std::shared_ptr<QByteArray> data;
@@ -145,6 +154,65 @@ TEST_CASE("nucleus/tile_scheduler/cache")
         CHECK(visited.contains({ 1, { 1, 1 } }));
     }
 
+    SECTION("visit_subtree starts at the given tile, even without ancestors")
+    {
+        nucleus::tile_scheduler::Cache<TestTile> cache;
+        cache.insert(TestTile { { 1, { 0, 0 } }, "green" });
+        cache.insert(TestTile { { 2, { 0, 0 } }, "green" });
+        cache.insert(TestTile { { 2, { 1, 1 } }, "red" });
+        cache.insert(TestTile { { 3, { 2, 2 } }, "green" });
+        cache.insert(TestTile { { 1, { 1, 1 } }, "green" });
+
+        std::unordered_set<tile::Id, tile::Id::Hasher> visited;
+        cache.visit_subtree({ 1, { 0, 0 } }, [&visited](const TestTile& t) {
+            visited.insert(t.id);
+            return t.data == "green";
+        });
+        CHECK(visited.size() == 3);
+        CHECK(visited.contains({ 1, { 0, 0 } }));
+        CHECK(visited.contains({ 2, { 0, 0 } }));
+        CHECK(visited.contains({ 2, { 1, 1 } }));
+
+        visited.clear();
+        cache.visit_subtree({ 2, { 3, 3 } }, [&visited](const TestTile& t) {
+            visited.insert(t.id);
+            return true;
+        });
+        CHECK(visited.empty());
+    }
+
+    SECTION("visit follows the tree when parents are purged and inserted again")
+    {
+        nucleus::tile_scheduler::Cache<TestTile> cache;
+        cache.insert(TestTile { { 2, { 0, 0 } }, "green" }); // children come first
+        cache.insert(TestTile { { 1, { 0, 0 } }, "green" });
+        cache.insert(TestTile { { 0, { 0, 0 } }, "green" });
+        cache.insert(TestTile { { 1, { 1, 0 } }, "green" });
+
+        const auto visit_all = [&cache]() {
+            std::unordered_set<tile::Id, tile::Id::Hasher> visited;
+            cache.visit([&visited](const TestTile& t) {
+                visited.insert(t.id);
+                return true;
+            });
+            return visited;
+        };
+        CHECK(visit_all().size() == 4);
+
+        // purge the root and level 1 tiles, leaving { 2, { 0, 0 } }, which was inserted last
+        QThread::msleep(2);
+        cache.insert(TestTile { { 2, { 0, 0 } }, "green" });
+        REQUIRE(cache.purge(1).size() == 3);
+        CHECK(visit_all().empty());
+
+        cache.insert(TestTile { { 0, { 0, 0 } }, "green" });
+        CHECK(visit_all().size() == 1);
+        cache.insert(TestTile { { 1, { 0, 0 } }, "green" });
+        const auto visited = visit_all();
+        CHECK(visited.size() == 3);
+        CHECK(visited.contains({ 2, { 0, 0 } }));
+    }
+
     SECTION("purge: all elements equal, large zoom levels first")
     {
         nucleus::tile_scheduler::Cache<TestTile> cache;
@@ -212,6 +280,21 @@ TEST_CASE("nucleus/tile_scheduler/cache")
         CHECK(cache.contains({ 0, { 0, 0 } }));
     }
 
+    SECTION("purge: touch updates the time")
+    {
+        nucleus::tile_scheduler::Cache<TestTile> cache;
+        cache.insert(TestTile { { 1, { 0, 0 } }, "older" });
+        cache.insert(TestTile { { 1, { 0, 1 } }, "older" });
+        QThread::msleep(2);
+        cache.insert(TestTile { { 1, { 1, 0 } }, "newer" });
+        QThread::msleep(2);
+        CHECK(cache.touch({ 1, { 0, 0 } }));
+        CHECK(!cache.touch({ 2, { 0, 0 } }));
+        const auto purged = cache.purge(2);
+        REQUIRE(purged.size() == 1);
+        CHECK(purged[0].id == tile::Id { 1, { 0, 1 } });
+    }
+
     SECTION("purge: visited elements are purged later than others")
     {
         nucleus::tile_scheduler::Cache<TestTile> cache;
@@ -251,6 +334,72 @@ TEST_CASE("nucleus/tile_scheduler/cache")
         CHECK(cache.contains({ 1, { 0, 0 } }));
     }
 
+    SECTION("purge: byte budget")
+    {
+        nucleus::tile_scheduler::Cache<SizedTestTile> cache;
+        cache.insert(SizedTestTile { { 0, { 0, 0 } }, std::string(10000, 'r') });
+        const auto single_size = cache.n_bytes();
+        CHECK(single_size > 10000);
+        QThread::msleep(2);
+        cache.insert(SizedTestTile { { 1, { 0, 0 } }, std::string(10000, 'g') });
+        cache.insert(SizedTestTile { { 1, { 1, 0 } }, std::string(10000, 'g') });
+        CHECK(cache.n_bytes() == 3 * single_size);
+
+        // overwriting updates the size
+        cache.insert(SizedTestTile { { 1, { 1, 0 } }, std::string(20000, 'g') });
+        CHECK(cache.n_bytes() == 3 * single_size + 10000);
+
+        CHECK(cache.purge(10, 10 * single_size).empty());
+        const auto purged = cache.purge(10, 3 * single_size);
+        REQUIRE(purged.size() == 1);
+        CHECK(purged.front().id == tile::Id { 0, { 0, 0 } });
+        CHECK(cache.n_bytes() == 3 * single_size + 10000 - single_size);
+        CHECK(cache.n_cached_objects() == 2);
+
+        // count and byte limits apply both
+        CHECK(cache.purge(1, 10 * single_size).size() == 1);
+        CHECK(cache.n_bytes() < 3 * single_size);
+    }
+
+    SECTION("erase")
+    {
+        nucleus::tile_scheduler::Cache<SizedTestTile> cache;
+        cache.insert(SizedTestTile { { 0, { 0, 0 } }, std::string(10000, 'r') });
+        const auto single_size = cache.n_bytes();
+        cache.insert(SizedTestTile { { 1, { 0, 0 } }, std::string(10000, 'g') });
+        cache.insert(SizedTestTile { { 2, { 0, 0 } }, std::string(10000, 'b') });
+
+        CHECK(cache.erase({ 1, { 0, 0 } }));
+        CHECK(!cache.erase({ 1, { 0, 0 } }));
+        CHECK(!cache.contains({ 1, { 0, 0 } }));
+        CHECK(cache.n_cached_objects() == 2);
+        CHECK(cache.n_bytes() == 2 * single_size);
+
+        // the child is not reachable without its parent
+        std::vector<tile::Id> visited;
+        cache.visit([&visited](const SizedTestTile& t) {
+            visited.push_back(t.id);
+            return true;
+        });
+        CHECK(visited == std::vector<tile::Id> { { 0, { 0, 0 } } });
+
+        // inserting it again links the child back in, and purging works with the entries left behind
+        QThread::msleep(2);
+        cache.insert(SizedTestTile { { 1, { 0, 0 } }, std::string(10000, 'g') });
+        visited.clear();
+        cache.visit([&visited](const SizedTestTile& t) {
+            visited.push_back(t.id);
+            return true;
+        });
+        CHECK(visited.size() == 3);
+        const auto purged = cache.purge(1);
+        REQUIRE(purged.size() == 2);
+        CHECK(cache.n_cached_objects() == 1);
+        CHECK(cache.n_bytes() == single_size);
+        CHECK(cache.purge(0).size() == 1);
+        CHECK(cache.n_bytes() == 0);
+    }
+
     SECTION("insert: insert overwrites existing objects")
     {
         nucleus::tile_scheduler::Cache<TestTile> cache;
@@ -284,19 +433,20 @@ TEST_CASE("nucleus/tile_scheduler/cache")
     };
     const auto verify_tile = [](const auto& cache, const tile::Id& id, int meta_data = 0) {
         REQUIRE(cache.contains(id));
-        const auto& tile = cache.peak_at(id);
-        CHECK(tile.id == id);
-        CHECK(tile.meta_data == meta_data);
-        CHECK(tile.n_children == 4);
+        const auto tile = cache.peak_at(id);
+        REQUIRE(tile);
+        CHECK(tile->id == id);
+        CHECK(tile->meta_data == meta_data);
+        CHECK(tile->n_children == 4);
         const auto ref_children = id.children();
         for (unsigned i = 0; i < 4; ++i) {
-            CHECK(tile.tiles[i].id == ref_children[i]);
-            REQUIRE(tile.tiles[i].data);
+            CHECK(tile->tiles[i].id == ref_children[i]);
+            REQUIRE(tile->tiles[i].data);
             std::stringstream ss;
             for (int j = 0; j < 1000; ++j)
                 ss << ref_children[i];
             QByteArray ref_ba(ss.str().c_str());
-            CHECK(*(tile.tiles[i].data) == ref_ba);
+            CHECK(*(tile->tiles[i].data) == ref_ba);
         }
     };
 
@@ -335,6 +485,162 @@ TEST_CASE("nucleus/tile_scheduler/cache")
         std::filesystem::remove_all(path);
     }
 
+    SECTION("disk cache is a single pack file plus journal, which are compacted") {
+        const auto path = std::filesystem::path(QStandardPaths::writableLocation(QStandardPaths::CacheLocation).toStdString()) / "test_tile_cache";
+        std::filesystem::remove_all(path);
+        const auto n_files = [&path]() { return std::distance(std::filesystem::directory_iterator(path), std::filesystem::directory_iterator {}); };
+        const auto pack_size = [&path]() {
+            uintmax_t size = 0;
+            for (const auto& entry : std::filesystem::directory_iterator(path))
+                size = std::max(size, entry.file_size());
+            return size;
+        };
+        {
+            nucleus::tile_scheduler::Cache<DiskWriteTestTile> cache;
+            for (unsigned i = 0; i < 10; ++i)
+                cache.insert(create_test_tile({ i, { 0, 0 } }));
+            CHECK(cache.write_to_disk(path).has_value());
+            CHECK(n_files() == 2);
+            const auto full_size = pack_size();
+
+            const auto journal_size = std::filesystem::file_size(path / "tiles.alp_journal");
+            cache.insert(create_test_tile({ 10, { 0, 0 } }));
+            CHECK(cache.write_to_disk(path).has_value());
+            CHECK(n_files() == 2);
+            CHECK(pack_size() > full_size);
+            // only one record is appended
+            CHECK(std::filesystem::file_size(path / "tiles.alp_journal") > journal_size);
+            CHECK(std::filesystem::file_size(path / "tiles.alp_journal") < journal_size + journal_size / 5);
+
+            cache.visit([](const auto&) { return true; });
+            cache.purge(2);
+            CHECK(cache.write_to_disk(path).has_value());
+            CHECK(n_files() == 2);
+            CHECK(pack_size() < full_size / 2);
+        }
+        {
+            nucleus::tile_scheduler::Cache<DiskWriteTestTile> cache;
+            CHECK(cache.read_from_disk(path).has_value());
+            CHECK(cache.n_cached_objects() == 2);
+            verify_tile(cache, { 0, { 0, 0 } });
+            verify_tile(cache, { 1, { 0, 0 } });
+        }
+        std::filesystem::remove_all(path);
+    }
+
+    SECTION("touched tiles are not written to disk again") {
+        const auto path = std::filesystem::path(QStandardPaths::writableLocation(QStandardPaths::CacheLocation).toStdString()) / "test_tile_cache";
+        std::filesystem::remove_all(path);
+        nucleus::tile_scheduler::Cache<DiskWriteTestTile> cache;
+        for (unsigned i = 0; i < 10; ++i)
+            cache.insert(create_test_tile({ i, { 0, 0 } }));
+        CHECK(cache.write_to_disk(path).has_value());
+        const auto journal_size = std::filesystem::file_size(path / "tiles.alp_journal");
+        for (unsigned i = 0; i < 10; ++i)
+            CHECK(cache.touch({ i, { 0, 0 } }));
+        CHECK(cache.write_to_disk(path).has_value());
+        CHECK(std::filesystem::file_size(path / "tiles.alp_journal") == journal_size);
+        std::filesystem::remove_all(path);
+    }
+
+    SECTION("removing the disk cache leaves other files in the directory alone") {
+        const auto path = std::filesystem::path(QStandardPaths::writableLocation(QStandardPaths::CacheLocation).toStdString()) / "test_tile_cache";
+        std::filesystem::remove_all(path);
+        {
+            nucleus::tile_scheduler::Cache<DiskWriteTestTile> cache;
+            cache.insert(create_test_tile({ 0, { 0, 0 } }));
+            CHECK(cache.write_to_disk(path).has_value());
+            CHECK(cache.write_to_disk(path / "nested").has_value());
+        }
+        {
+            QFile other_file(path / "other.alp");
+            REQUIRE(other_file.open(QIODeviceBase::WriteOnly));
+            other_file.write("other");
+        }
+        nucleus::tile_scheduler::Cache<DiskWriteTestTile>::remove_from_disk(path);
+        CHECK(std::filesystem::exists(path / "other.alp"));
+        CHECK(!std::filesystem::exists(path / "tiles.alp_journal"));
+        {
+            nucleus::tile_scheduler::Cache<DiskWriteTestTile> cache;
+            CHECK(!cache.read_from_disk(path).has_value());
+            CHECK(cache.read_from_disk(path / "nested").has_value());
+            CHECK(cache.n_cached_objects() == 1);
+        }
+        std::filesystem::remove_all(path);
+    }
+
+    SECTION("tiles are paged in lazily after reading from disk") {
+        const auto path = std::filesystem::path(QStandardPaths::writableLocation(QStandardPaths::CacheLocation).toStdString()) / "test_tile_cache";
+        std::filesystem::remove_all(path);
+        {
+            nucleus::tile_scheduler::Cache<DiskWriteTestTile> cache;
+            for (unsigned i = 0; i < 10; ++i)
+                cache.insert(create_test_tile({ i, { 0, 0 } }));
+            cache.insert(create_test_tile({ 356, { 20, 564 } }));
+            CHECK(cache.write_to_disk(path).has_value());
+        }
+        {
+            nucleus::tile_scheduler::Cache<DiskWriteTestTile> cache;
+            CHECK(cache.read_from_disk(path).has_value());
+            CHECK(cache.n_cached_objects() == 11);
+            CHECK(cache.n_paged_out_objects() == 11);
+
+            verify_tile(cache, { 356, { 20, 564 } });
+            CHECK(cache.n_paged_out_objects() == 10);
+
+            cache.visit([](const DiskWriteTestTile& tile) { return tile.id.zoom_level < 3; });
+            CHECK(cache.n_paged_out_objects() == 6);
+
+            // tiles that are still paged out are copied over when the pack is rewritten (a missing journal forces a rewrite)
+            cache.insert(create_test_tile({ 0, { 0, 0 } }, 1));
+            cache.purge(10);
+            std::filesystem::remove(path / "tiles.alp_journal");
+            CHECK(cache.write_to_disk(path).has_value());
+            verify_tile(cache, { 0, { 0, 0 } }, 1);
+            for (unsigned i = 1; i < 10; ++i)
+                verify_tile(cache, { i, { 0, 0 } });
+        }
+        {
+            nucleus::tile_scheduler::Cache<DiskWriteTestTile> cache;
+            CHECK(cache.read_from_disk(path).has_value());
+            CHECK(cache.n_cached_objects() == 10);
+            verify_tile(cache, { 0, { 0, 0 } }, 1);
+            for (unsigned i = 1; i < 10; ++i)
+                verify_tile(cache, { i, { 0, 0 } });
+        }
+        std::filesystem::remove_all(path);
+    }
+
+    SECTION("purge: the stored byte budget counts paged out tiles with their size on disk") {
+        const auto path = std::filesystem::path(QStandardPaths::writableLocation(QStandardPaths::CacheLocation).toStdString()) / "test_tile_cache";
+        std::filesystem::remove_all(path);
+        {
+            nucleus::tile_scheduler::Cache<DiskWriteTestTile> cache;
+            for (unsigned i = 0; i < 10; ++i)
+                cache.insert(create_test_tile({ i, { 0, 0 } }));
+            CHECK(cache.write_to_disk(path).has_value());
+        }
+        nucleus::tile_scheduler::Cache<DiskWriteTestTile> cache;
+        CHECK(cache.read_from_disk(path).has_value());
+        REQUIRE(cache.n_paged_out_objects() == 10);
+        // paged out tiles take hardly any memory, but their records are in the pack
+        const auto n_stored_bytes = cache.n_stored_bytes();
+        CHECK(n_stored_bytes > 10 * 4 * 1000);
+        uintmax_t pack_size = 0;
+        for (const auto& entry : std::filesystem::directory_iterator(path)) {
+            if (entry.path().extension() == ".alp_pack")
+                pack_size += entry.file_size();
+        }
+        CHECK(n_stored_bytes < pack_size);
+        CHECK(cache.purge(100, cache.n_bytes()).empty());
+
+        const auto purged = cache.purge(100, std::numeric_limits<uint64_t>::max(), n_stored_bytes / 2);
+        CHECK(purged.size() >= 5);
+        CHECK(purged.size() < 10);
+        CHECK(cache.n_stored_bytes() <= n_stored_bytes / 2);
+        std::filesystem::remove_all(path);
+    }
+
     SECTION("reading disk cache back fails on bad version") {
         const auto path = std::filesystem::path(QStandardPaths::writableLocation(QStandardPaths::CacheLocation).toStdString()) / "test_tile_cache";
         std::filesystem::remove_all(path);
@@ -351,6 +657,65 @@ TEST_CASE("nucleus/tile_scheduler/cache")
         std::filesystem::remove_all(path);
     }
 
+    SECTION("truncated or corrupt pack files don't yield broken tiles") {
+        const auto path = std::filesystem::path(QStandardPaths::writableLocation(QStandardPaths::CacheLocation).toStdString()) / "test_tile_cache";
+        const auto pack_file_path = [&path]() {
+            for (const auto& entry : std::filesystem::directory_iterator(path)) {
+                if (entry.path().extension() == ".alp_pack")
+                    return entry.path();
+            }
+            return std::filesystem::path();
+        };
+        const auto write_cache = [&]() {
+            std::filesystem::remove_all(path);
+            nucleus::tile_scheduler::Cache<DiskWriteTestTile> cache;
+            for (unsigned i = 0; i < 3; ++i)
+                cache.insert(create_test_tile({ i, { 0, 0 } }));
+            REQUIRE(cache.write_to_disk(path).has_value());
+        };
+
+        // the journal references data behind the end of the pack
+        write_cache();
+        std::filesystem::resize_file(pack_file_path(), std::filesystem::file_size(pack_file_path()) - 100);
+        {
+            nucleus::tile_scheduler::Cache<DiskWriteTestTile> cache;
+            CHECK(!cache.read_from_disk(path).has_value());
+            CHECK(cache.n_cached_objects() == 0);
+            CHECK(!cache.peak_at({ 0, { 0, 0 } }));
+        }
+
+        // the index is fine, but the id of the first tile in the pack (right after the header) is garbage
+        write_cache();
+        {
+            QFile file(pack_file_path());
+            REQUIRE(file.open(QIODeviceBase::ReadWrite));
+            REQUIRE(file.seek(2 * 25 + sizeof(uint64_t)));
+            file.write(QByteArray(int(sizeof(tile::Id)), char(0xff)));
+        }
+        {
+            nucleus::tile_scheduler::Cache<DiskWriteTestTile> cache;
+            REQUIRE(cache.read_from_disk(path).has_value());
+            CHECK(cache.n_cached_objects() == 3);
+            unsigned n_broken = 0;
+            for (unsigned i = 0; i < 3; ++i) {
+                const auto tile = cache.peak_at({ i, { 0, 0 } });
+                if (tile)
+                    CHECK(tile->id == tile::Id { i, { 0, 0 } });
+                else
+                    ++n_broken;
+            }
+            CHECK(n_broken == 1);
+            CHECK(cache.n_paged_out_objects() == 1);
+            unsigned n_visited = 0;
+            cache.visit([&n_visited](const DiskWriteTestTile&) {
+                ++n_visited;
+                return true;
+            });
+            CHECK(n_visited < 3);
+        }
+        std::filesystem::remove_all(path);
+    }
+
     SECTION("write to disk and read back itteratively") {
         const auto path = std::filesystem::path(QStandardPaths::writableLocation(QStandardPaths::CacheLocation).toStdString()) / "test_tile_cache";
         std::filesystem::remove_all(path);
@@ -479,3 +844,134 @@ TEST_CASE("nucleus/tile_scheduler/cache")
         std::filesystem::remove_all(path);
     }
 }
+
+namespace {
+std::vector<tile::Id> full_tree(unsigned max_zoom_level)
+{
+    std::vector<tile::Id> ids = { { 0, { 0, 0 } } };
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (ids[i].zoom_level >= max_zoom_level)
+            continue;
+        for (const auto& child : ids[i].children())
+            ids.push_back(child);
+    }
+    return ids;
+}
+} // namespace
+
+#ifdef ALP_ENABLE_THREADING
+TEST_CASE("nucleus/tile_scheduler/cache concurrency")
+{
+    SECTION("concurrent visits, inserts and peaks")
+    {
+        nucleus::tile_scheduler::Cache<TestTile> cache;
+        const auto ids = full_tree(5);
+        for (const auto& id : ids)
+            cache.insert(TestTile { id, "green" });
+
+        std::atomic<bool> stop = false;
+        std::atomic<unsigned> n_bad_visits = 0;
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < 3; ++i) {
+            threads.emplace_back([&]() {
+                while (!stop) {
+                    cache.visit([&](const TestTile& t) {
+                        if (t.data != "green")
+                            ++n_bad_visits;
+                        return true;
+                    });
+                }
+            });
+        }
+        threads.emplace_back([&]() {
+            for (unsigned i = 0; i < 1000; ++i)
+                cache.insert(TestTile { { 20, { i, 0 } }, "green" });
+            stop = true;
+        });
+        for (unsigned i = 0; i < 1000; ++i)
+            CHECK(cache.peak_at(ids[i % ids.size()])->data == "green");
+        for (auto& thread : threads)
+            thread.join();
+
+        CHECK(n_bad_visits == 0);
+        CHECK(cache.n_cached_objects() == ids.size() + 1000);
+    }
+}
+#endif
+
+TEST_CASE("nucleus/tile_scheduler/cache benchmarks")
+{
+    nucleus::tile_scheduler::Cache<TestTile> cache;
+    const auto ids = full_tree(7);
+    for (const auto& id : ids)
+        cache.insert(TestTile { id, "green" });
+
+    BENCHMARK("visit " + std::to_string(ids.size()) + " tiles")
+    {
+        unsigned n = 0;
+        cache.visit([&n](const TestTile&) {
+            ++n;
+            return true;
+        });
+        return n;
+    };
+
+    {
+        // a complete tree down to zoom level 8 has 87381 tiles, plus 12619 unconnected ones on zoom level 20
+        nucleus::tile_scheduler::Cache<TestTile> large_cache;
+        const unsigned n = 100'000;
+        for (const auto& id : full_tree(8))
+            large_cache.insert(TestTile { id, "green" });
+        unsigned x = 0;
+        while (large_cache.n_cached_objects() < n)
+            large_cache.insert(TestTile { { 20, { x++, 0 } }, "green" });
+        BENCHMARK("insert 100 and purge 100 tiles of a 100k tile cache")
+        {
+            for (unsigned i = 0; i < 100; ++i)
+                large_cache.insert(TestTile { { 20, { x++, 0 } }, "green" });
+            return large_cache.purge(n);
+        };
+        // worst case, all entries of the tree are outdated
+        BENCHMARK("insert 100, visit all and purge 100 tiles of a 100k tile cache")
+        {
+            for (unsigned i = 0; i < 100; ++i)
+                large_cache.insert(TestTile { { 20, { x++, 0 } }, "green" });
+            large_cache.visit([](const TestTile&) { return true; });
+            return large_cache.purge(n);
+        };
+    }
+
+#ifdef ALP_ENABLE_THREADING
+    {
+        // the querier on the gui thread and the scheduler traverse at the same time, while tiles arrive.
+        std::atomic<bool> stop = false;
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < 2; ++i) {
+            threads.emplace_back([&]() {
+                while (!stop)
+                    cache.visit([](const TestTile& t) { return t.id.zoom_level < 5; });
+            });
+        }
+        threads.emplace_back([&]() {
+            unsigned x = 0;
+            while (!stop) {
+                cache.insert(TestTile { { 20, { x++ % 1000, 0 } }, "green" });
+                std::this_thread::yield();
+            }
+        });
+
+        BENCHMARK("visit " + std::to_string(ids.size()) + " tiles with 2 concurrent visitors and 1 inserter")
+        {
+            unsigned n = 0;
+            cache.visit([&n](const TestTile&) {
+                ++n;
+                return true;
+            });
+            return n;
+        };
+        stop = true;
+        for (auto& thread : threads)
+            thread.join();
+    }
+#endif
+}
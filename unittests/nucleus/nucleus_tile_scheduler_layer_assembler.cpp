@@ -195,4 +195,79 @@ TEST_CASE("nucleus/tile_scheduler/layer assembler")
         REQUIRE(!loaded_tile.height->size());
         CHECK(assembler.n_items_in_flight() == 0);
     }
+
+    SECTION("cancel drops partial data and is passed on")
+    {
+        QSignalSpy spy_loaded(&assembler, &LayerAssembler::tile_loaded);
+        QSignalSpy spy_cancelled(&assembler, &LayerAssembler::tile_cancelled);
+        assembler.load(tile::Id { 0, { 0, 0 } });
+        assembler.deliver_ortho(good_tile({ 0, { 0, 0 } }, "ortho"));
+        CHECK(assembler.n_items_in_flight() == 1);
+
+        assembler.cancel(tile::Id { 0, { 0, 0 } });
+        CHECK(assembler.n_items_in_flight() == 0);
+        REQUIRE(spy_cancelled.size() == 1);
+        CHECK(spy_cancelled.constFirst().constFirst().value<tile::Id>() == tile::Id { 0, { 0, 0 } });
+        CHECK(spy_loaded.empty());
+    }
+
+    SECTION("heights arriving first are passed on as preliminary tile")
+    {
+        QSignalSpy spy_loaded(&assembler, &LayerAssembler::tile_loaded);
+        QSignalSpy spy_preliminary(&assembler, &LayerAssembler::preliminary_tile_loaded);
+        assembler.load(tile::Id { 0, { 0, 0 } });
+        assembler.load(tile::Id { 1, { 0, 0 } });
+        assembler.load(tile::Id { 1, { 1, 0 } });
+        assembler.deliver_height(good_tile({ 0, { 0, 0 } }, "height"));
+        assembler.deliver_ortho(good_tile({ 1, { 0, 0 } }, "ortho"));
+        assembler.deliver_height(good_tile({ 1, { 0, 0 } }, "height"));
+        assembler.deliver_height(missing_tile({ 1, { 1, 0 } }));
+        REQUIRE(spy_preliminary.size() == 1); // not if the ortho is there already, or if the heights are missing
+        const auto preliminary = spy_preliminary.constFirst().constFirst().value<LayeredTile>();
+        CHECK(preliminary.id == tile::Id { 0, { 0, 0 } });
+        CHECK(preliminary.network_info.status == NetworkInfo::Status::Good);
+        CHECK(*preliminary.height == "height");
+        REQUIRE(preliminary.ortho);
+        CHECK(preliminary.ortho->isEmpty());
+        CHECK(spy_loaded.size() == 1);
+
+        assembler.deliver_ortho(good_tile({ 0, { 0, 0 } }, "ortho"));
+        CHECK(spy_loaded.size() == 2);
+        CHECK(spy_preliminary.size() == 1);
+    }
+
+    SECTION("validators are kept for good tiles and split for revalidation")
+    {
+        auto ortho = good_tile({ 0, { 0, 0 } }, "ortho");
+        ortho.validators.etag = "\"o\"";
+        auto height = good_tile({ 0, { 0, 0 } }, "height");
+        height.validators.last_modified = "Wed, 21 Oct 2015 07:28:00 GMT";
+        const auto joined = LayerAssembler::join(ortho, height);
+        CHECK(joined.ortho_validators.etag == "\"o\"");
+        CHECK(joined.height_validators.last_modified == "Wed, 21 Oct 2015 07:28:00 GMT");
+        CHECK(LayerAssembler::join(ortho, missing_tile({ 0, { 0, 0 } })).ortho_validators.empty());
+
+        QSignalSpy spy_ortho(&assembler, &LayerAssembler::ortho_validators_announced);
+        QSignalSpy spy_height(&assembler, &LayerAssembler::height_validators_announced);
+        QSignalSpy spy_requested(&assembler, &LayerAssembler::tile_requested);
+        std::vector<std::string> order;
+        QObject::connect(&assembler, &LayerAssembler::ortho_validators_announced, [&order]() { order.push_back("validators"); });
+        QObject::connect(&assembler, &LayerAssembler::tile_requested, [&order]() { order.push_back("request"); });
+        assembler.revalidate({ { tile::Id { 1, { 0, 0 } }, joined.ortho_validators, {} }, { tile::Id { 1, { 1, 0 } }, joined.ortho_validators, {} } });
+        CHECK(spy_ortho.empty()); // announced with the request only, validators of tiles that are never requested don't pile up
+
+        assembler.load(tile::Id { 1, { 0, 0 } });
+        REQUIRE(spy_ortho.size() == 1);
+        CHECK(spy_ortho.constFirst().constFirst().value<tile::Id>() == tile::Id { 1, { 0, 0 } });
+        CHECK(spy_ortho.constFirst().constLast().value<CacheValidators>().etag == "\"o\"");
+        CHECK(spy_height.empty()); // nothing to revalidate
+        CHECK(order == std::vector<std::string> { "validators", "request" });
+
+        // validators are used once, and each list replaces the previous one
+        assembler.load(tile::Id { 1, { 0, 0 } });
+        assembler.revalidate({});
+        assembler.load(tile::Id { 1, { 1, 0 } });
+        CHECK(spy_ortho.size() == 1);
+        CHECK(spy_requested.size() == 3);
+    }
 }
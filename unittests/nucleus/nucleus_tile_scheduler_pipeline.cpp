@@ -0,0 +1,160 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
+#include <QFile>
+#include <QNetworkAccessManager>
+#include <QSignalSpy>
+#include <catch2/catch_test_macros.hpp>
+
+#include "MockTileServer.h"
+#include "nucleus/camera/LinearCameraAnimation.h"
+#include "nucleus/camera/PositionStorage.h"
+#include "nucleus/tile_scheduler/Scheduler.h"
+#include "nucleus/tile_scheduler/SlotLimiter.h"
+#include "nucleus/tile_scheduler/TileLoadService.h"
+#include "nucleus/tile_scheduler/setup.h"
+#include "nucleus/tile_scheduler/utils.h"
+#include "radix/TileHeights.h"
+#include "test_helpers.h"
+
+using namespace nucleus::tile_scheduler;
+
+namespace {
+QByteArray read_test_file(const char* name)
+{
+    QFile file(QString("%1%2").arg(ALP_TEST_DATA_DIR, name));
+    const auto open = file.open(QFile::ReadOnly);
+    REQUIRE(open);
+    return file.readAll();
+}
+
+// the pipeline as wired in nucleus::Controller, against a local mock server.
+// flies from stephansdom to grossglockner and records when each quad was requested and delivered.
+struct LoadTest {
+    using Clock = std::chrono::steady_clock;
+    unittests::MockTileServer server;
+    std::shared_ptr<QNetworkAccessManager> network_manager;
+    std::unique_ptr<TileLoadService> ortho_service;
+    std::unique_ptr<TileLoadService> height_service;
+    std::unique_ptr<Scheduler> scheduler;
+    setup::Pipeline pipeline = {};
+    std::unordered_map<tile::Id, Clock::time_point, tile::Id::Hasher> requested_at;
+    std::vector<float> latencies; // msecs
+    unsigned n_delivered = 0;
+
+    explicit LoadTest(const unittests::MockTileServer::Settings& settings)
+        : server(settings, {})
+        , network_manager(std::make_shared<QNetworkAccessManager>())
+    {
+        server.set_payload(".jpeg", read_test_file("test-tile_ortho.jpeg"));
+        server.set_payload(".png", read_test_file("test-tile.png"));
+        ortho_service = std::make_unique<TileLoadService>(server.base_url() + "ortho/", TileLoadService::UrlPattern::ZXY, ".jpeg");
+        height_service = std::make_unique<TileLoadService>(server.base_url() + "height/", TileLoadService::UrlPattern::ZXY, ".png");
+        ortho_service->set_network_manager(network_manager);
+        height_service->set_network_manager(network_manager);
+
+        scheduler = std::make_unique<Scheduler>(Scheduler::white_jpeg_tile(256), Scheduler::black_png_tile(64));
+        QFile file(":/map/height_data.atb");
+        const auto open = file.open(QIODeviceBase::OpenModeFlag::ReadOnly);
+        REQUIRE(open);
+        scheduler->set_aabb_decorator(utils::AabbDecorator::make(TileHeights::deserialise(file.readAll())));
+        scheduler->set_gpu_quad_limit(512);
+        scheduler->set_update_timeout(16);
+        pipeline = setup::connect_pipeline(scheduler.get(), ortho_service.get(), height_service.get());
+
+        QObject::connect(pipeline.slot_limiter, &SlotLimiter::quad_requested, [this](const tile::Id& id) { requested_at[id] = Clock::now(); });
+        QObject::connect(pipeline.slot_limiter, &SlotLimiter::quad_cancelled, [this](const tile::Id& id) { requested_at.erase(id); });
+        QObject::connect(pipeline.slot_limiter, &SlotLimiter::quad_delivered, [this](const tile_types::TileQuad& quad) {
+            const auto iter = requested_at.find(quad.id);
+            if (iter == requested_at.end())
+                return;
+            latencies.push_back(std::chrono::duration<float, std::milli>(Clock::now() - iter->second).count());
+            requested_at.erase(iter);
+            ++n_delivered;
+        });
+    }
+
+    struct Report {
+        float total_time; // msecs
+        float time_to_complete_view; // msecs after the camera stopped
+        float quads_per_second;
+        float p50, p95, p99; // per quad latency in msecs
+    };
+
+    Report run()
+    {
+        auto camera = nucleus::camera::stored_positions::stephansdom();
+        camera.set_viewport_size({ 1920, 1080 });
+        auto end_camera = nucleus::camera::stored_positions::grossglockner();
+        end_camera.set_viewport_size({ 1920, 1080 });
+
+        const auto start = Clock::now();
+        scheduler->set_enabled(true);
+        scheduler->update_camera(camera);
+        nucleus::camera::LinearCameraAnimation animation(camera, end_camera);
+        while (const auto next = animation.update(camera, nullptr)) {
+            camera = next.value();
+            scheduler->update_camera(camera);
+            test_helpers::process_events_for(16);
+        }
+        const auto camera_stopped = Clock::now();
+        // a delivery triggers new requests after the update timeout, hence idle means nothing in flight for a while.
+        unsigned idle = 0;
+        while (idle < 3 && Clock::now() - camera_stopped < std::chrono::seconds(60)) {
+            test_helpers::process_events_for(16);
+            idle = pipeline.slot_limiter->slots_taken() == 0 ? idle + 1 : 0;
+        }
+        const auto end = Clock::now() - std::chrono::milliseconds(3 * 16);
+
+        Report report = {};
+        report.total_time = std::chrono::duration<float, std::milli>(end - start).count();
+        report.time_to_complete_view = std::chrono::duration<float, std::milli>(end - camera_stopped).count();
+        report.quads_per_second = float(n_delivered) / (report.total_time / 1000.f);
+        std::sort(latencies.begin(), latencies.end());
+        const auto percentile = [this](float p) { return latencies.empty() ? 0.f : latencies[size_t(p * float(latencies.size() - 1))]; };
+        report.p50 = percentile(0.50f);
+        report.p95 = percentile(0.95f);
+        report.p99 = percentile(0.99f);
+        return report;
+    }
+};
+} // namespace
+
+// hidden, run with: unittests_nucleus "[pipeline]"
+TEST_CASE("nucleus/tile_scheduler/pipeline load test", "[.][pipeline]")
+{
+    using Settings = unittests::MockTileServer::Settings;
+    const std::vector<std::pair<std::string, Settings>> scenarios = {
+        { "local (5ms)", Settings { .latency = 5 } },
+        { "fast network (30ms +- 10ms, 50 MB/s)", Settings { .latency = 25, .jitter = 10, .bandwidth = 50'000'000 } },
+        { "slow network (80ms +- 40ms, 2 MB/s, 2% 404, 1% errors)",
+            Settings { .latency = 60, .jitter = 40, .bandwidth = 2'000'000, .not_found_rate = 0.02f, .error_rate = 0.01f } },
+    };
+    for (const auto& [name, settings] : scenarios) {
+        LoadTest load_test(settings);
+        const auto report = load_test.run();
+        CHECK(load_test.n_delivered > 0);
+        WARN(name << ": " << load_test.n_delivered << " quads in " << report.total_time << "ms (" << report.quads_per_second << " quads/s), "
+                  << "view complete " << report.time_to_complete_view << "ms after the camera stopped, "
+                  << "latency p50/p95/p99: " << report.p50 << "/" << report.p95 << "/" << report.p99 << "ms");
+    }
+}
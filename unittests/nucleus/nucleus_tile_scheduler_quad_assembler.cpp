@@ -233,4 +233,78 @@ TEST_CASE("nucleus/tile_scheduler/quad assembler")
         CHECK(loaded_tile.id == tile::Id { 0, { 0, 0 } });
         CHECK(loaded_tile.network_info().status == NetworkInfo::Status::NotFound);
     }
+
+    SECTION("cancel")
+    {
+        QSignalSpy spy_loaded(&assembler, &QuadAssembler::quad_loaded);
+        QSignalSpy spy_cancelled(&assembler, &QuadAssembler::tile_cancelled);
+
+        assembler.load(tile::Id { 0, { 0, 0 } });
+        assembler.deliver_tile(good_tile({ 1, { 0, 0 } }, "ortho 100", "height 100"));
+        assembler.cancel(tile::Id { 0, { 0, 0 } });
+        CHECK(assembler.n_items_in_flight() == 0);
+        REQUIRE(spy_cancelled.size() == 4);
+        CHECK(spy_cancelled[0].constFirst().value<tile::Id>() == tile::Id { 1, { 0, 0 } }); // order should not matter.
+        CHECK(spy_cancelled[1].constFirst().value<tile::Id>() == tile::Id { 1, { 1, 0 } });
+        CHECK(spy_cancelled[2].constFirst().value<tile::Id>() == tile::Id { 1, { 0, 1 } });
+        CHECK(spy_cancelled[3].constFirst().value<tile::Id>() == tile::Id { 1, { 1, 1 } });
+
+        // tiles arriving after the cancellation are dropped
+        assembler.deliver_tile(good_tile({ 1, { 0, 1 } }, "ortho 101", "height 101"));
+        assembler.deliver_tile(good_tile({ 1, { 1, 0 } }, "ortho 110", "height 110"));
+        assembler.deliver_tile(good_tile({ 1, { 1, 1 } }, "ortho 111", "height 111"));
+        CHECK(assembler.n_items_in_flight() == 0);
+        CHECK(spy_loaded.empty());
+
+        // cancelling something unknown is a no-op
+        assembler.cancel(tile::Id { 3, { 4, 5 } });
+        CHECK(spy_cancelled.size() == 4);
+    }
+
+    SECTION("preliminary quad, once all children have heights")
+    {
+        QSignalSpy spy_loaded(&assembler, &QuadAssembler::quad_loaded);
+        QSignalSpy spy_preliminary(&assembler, &QuadAssembler::preliminary_quad_loaded);
+        const auto heights_only = [](const tile::Id& id, const char* height_bytes) {
+            auto tile = good_tile(id, "", height_bytes);
+            tile.ortho = std::make_shared<QByteArray>();
+            return tile;
+        };
+
+        assembler.load(tile::Id { 0, { 0, 0 } });
+        assembler.deliver_preliminary_tile(heights_only({ 1, { 0, 0 } }, "height 100"));
+        assembler.deliver_tile(good_tile({ 1, { 0, 1 } }, "ortho 101", "height 101"));
+        assembler.deliver_preliminary_tile(heights_only({ 1, { 1, 0 } }, "height 110"));
+        CHECK(spy_preliminary.empty());
+        assembler.deliver_preliminary_tile(heights_only({ 1, { 1, 1 } }, "height 111"));
+        REQUIRE(spy_preliminary.size() == 1);
+        CHECK(spy_loaded.empty());
+
+        const auto preliminary = spy_preliminary.constFirst().constFirst().value<tile_types::TileQuad>();
+        CHECK(preliminary.id == tile::Id { 0, { 0, 0 } });
+        REQUIRE(preliminary.n_tiles == 4);
+        for (unsigned i = 0; i < 4; ++i) {
+            const auto& tile = preliminary.tiles[i];
+            const auto number = std::to_string(tile.id.zoom_level) + std::to_string(tile.id.coords.x) + std::to_string(tile.id.coords.y);
+            CHECK(*tile.height == QByteArray((std::string("height ") + number).c_str()));
+            if (tile.id == tile::Id { 1, { 0, 1 } })
+                CHECK(*tile.ortho == "ortho 101"); // complete tiles take precedence
+            else
+                CHECK(tile.ortho->isEmpty());
+        }
+
+        assembler.deliver_tile(good_tile({ 1, { 0, 0 } }, "ortho 100", "height 100"));
+        assembler.deliver_tile(good_tile({ 1, { 1, 0 } }, "ortho 110", "height 110"));
+        assembler.deliver_tile(good_tile({ 1, { 1, 1 } }, "ortho 111", "height 111"));
+        CHECK(spy_preliminary.size() == 1);
+        REQUIRE(spy_loaded.size() == 1);
+        CHECK(assembler.n_items_in_flight() == 0);
+
+        // quads that complete right away are not reported as preliminary
+        assembler.load(tile::Id { 3, { 4, 5 } });
+        for (const auto& id : tile::Id { 3, { 4, 5 } }.children())
+            assembler.deliver_tile(good_tile(id, "ortho", "height"));
+        CHECK(spy_loaded.size() == 2);
+        CHECK(spy_preliminary.size() == 1);
+    }
 }
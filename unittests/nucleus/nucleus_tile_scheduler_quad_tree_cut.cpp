@@ -0,0 +1,206 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <QFile>
+
+#include "nucleus/camera/PositionStorage.h"
+#include "nucleus/tile_scheduler/QuadTreeCut.h"
+#include "nucleus/tile_scheduler/utils.h"
+#include "radix/TileHeights.h"
+#include "radix/quad_tree.h"
+
+using nucleus::tile_scheduler::QuadTreeCut;
+
+namespace {
+nucleus::tile_scheduler::utils::AabbDecoratorPtr height_data_decorator()
+{
+    QFile file(":/map/height_data.atb");
+    const auto open = file.open(QIODeviceBase::OpenModeFlag::ReadOnly);
+    assert(open);
+    Q_UNUSED(open);
+    return nucleus::tile_scheduler::utils::AabbDecorator::make(TileHeights::deserialise(file.readAll()));
+}
+
+struct FullCut {
+    QuadTreeCut::TileSet inner_nodes;
+    QuadTreeCut::TileSet leaves;
+};
+
+FullCut full_traversal(const nucleus::camera::Definition& camera, const nucleus::tile_scheduler::utils::AabbDecoratorPtr& decorator, float error_threshold_px)
+{
+    FullCut cut;
+    const auto leaves = quad_tree::onTheFlyTraverse(
+        tile::Id { 0, { 0, 0 } }, nucleus::tile_scheduler::utils::refineFunctor(camera, decorator, error_threshold_px), [&cut](const tile::Id& v) {
+            cut.inner_nodes.insert(v);
+            return v.children();
+        });
+    cut.leaves.insert(leaves.cbegin(), leaves.cend());
+    return cut;
+}
+
+// a camera orbiting around grossglockner, first around the vertical axis in steps of one degree (a full circle), then tilting.
+std::vector<nucleus::camera::Definition> orbit_path()
+{
+    auto camera = nucleus::camera::stored_positions::grossglockner();
+    camera.set_viewport_size({ 1920, 1080 });
+    const auto centre = camera.calculate_lookat_position(500);
+    std::vector<nucleus::camera::Definition> path;
+    for (int i = 0; i < 360; ++i) {
+        camera.orbit(centre, { 1.0, 0.0 });
+        path.push_back(camera);
+    }
+    for (int i = 0; i < 80; ++i) {
+        camera.orbit_clamped(centre, { 0.0, 0.25 });
+        path.push_back(camera);
+    }
+    return path;
+}
+
+// flying past grossglockner while turning, the camera moves and rotates in every step. the steps are small, so that decisions are
+// kept until they are close to their margins, where the rotation around the moved camera position matters.
+std::vector<nucleus::camera::Definition> fly_by_path()
+{
+    auto camera = nucleus::camera::stored_positions::grossglockner();
+    camera.set_viewport_size({ 1920, 1080 });
+    std::vector<nucleus::camera::Definition> path;
+    for (int i = 0; i < 300; ++i) {
+        camera.move(-camera.z_axis() * 25.0 + camera.x_axis() * 10.0);
+        camera.orbit(camera.position(), { 0.4, 0.0 });
+        path.push_back(camera);
+    }
+    return path;
+}
+} // namespace
+
+TEST_CASE("nucleus/tile_scheduler/quad tree cut")
+{
+    const auto decorator = height_data_decorator();
+
+    SECTION("is the same as a full traversal along an orbit, but evaluates fewer tiles")
+    {
+        QuadTreeCut cut;
+        size_t n_evaluated = 0;
+        size_t n_traversed = 0;
+        const auto path = orbit_path();
+        for (size_t i = 0; i < path.size(); ++i) {
+            cut.update(path[i], decorator, 2);
+            const auto expected = full_traversal(path[i], decorator, 2);
+            REQUIRE(cut.inner_nodes() == expected.inner_nodes);
+            REQUIRE(cut.leaves() == expected.leaves);
+            if (i == 0)
+                continue; // builds the cut from scratch
+            n_evaluated += cut.n_evaluated();
+            n_traversed += expected.inner_nodes.size() + expected.leaves.size();
+        }
+        CHECK(n_evaluated * 2 < n_traversed);
+    }
+
+    SECTION("is the same as a full traversal while moving and turning at the same time")
+    {
+        QuadTreeCut cut;
+        for (const auto& camera : fly_by_path()) {
+            cut.update(camera, decorator, 2);
+            const auto expected = full_traversal(camera, decorator, 2);
+            REQUIRE(cut.inner_nodes() == expected.inner_nodes);
+            REQUIRE(cut.leaves() == expected.leaves);
+        }
+    }
+
+    SECTION("is the same as a full traversal after jumps and projection changes")
+    {
+        QuadTreeCut cut;
+        auto cameras = std::vector {
+            nucleus::camera::stored_positions::grossglockner(),
+            nucleus::camera::stored_positions::stephansdom(),
+            nucleus::camera::stored_positions::karwendel(),
+            nucleus::camera::stored_positions::karwendel(),
+            nucleus::camera::stored_positions::oestl_hochgrubach_spitze(),
+        };
+        cameras[3].set_viewport_size({ 1920, 1080 });
+        cameras[4].set_field_of_view(30);
+        for (const auto& camera : cameras) {
+            cut.update(camera, decorator, 2);
+            const auto expected = full_traversal(camera, decorator, 2);
+            CHECK(cut.inner_nodes() == expected.inner_nodes);
+            CHECK(cut.leaves() == expected.leaves);
+        }
+        cut.update(cameras.back(), decorator, 2);
+        CHECK(cut.n_evaluated() == 0); // nothing changed
+    }
+
+    SECTION("invalidated tiles are evaluated again, rejected ones on every update")
+    {
+        QuadTreeCut cut;
+        const auto camera = nucleus::camera::stored_positions::grossglockner();
+        const auto accept_all = [](const tile::Id&) { return true; };
+        cut.update(camera, decorator, 2, 256, accept_all);
+        REQUIRE(cut.inner_nodes().contains(tile::Id { 2, { 2, 2 } }));
+        REQUIRE(cut.inner_nodes().contains(tile::Id { 3, { 4, 5 } }));
+
+        // without invalidation, the filter is not asked again
+        const auto in_subtree = [](const tile::Id& id) {
+            return id.zoom_level >= 3 && (id.coords.x >> (id.zoom_level - 3)) == 4 && (id.coords.y >> (id.zoom_level - 3)) == 5;
+        };
+        const auto reject_subtree = [&in_subtree](const tile::Id& id) { return !in_subtree(id); };
+        cut.update(camera, decorator, 2, 256, reject_subtree);
+        CHECK(cut.inner_nodes().contains(tile::Id { 3, { 4, 5 } }));
+
+        cut.invalidate(tile::Id { 3, { 4, 5 } });
+        cut.update(camera, decorator, 2, 256, reject_subtree);
+        CHECK(cut.n_evaluated() == 1);
+        CHECK(cut.leaves().contains(tile::Id { 3, { 4, 5 } }));
+        CHECK(!cut.inner_nodes().contains(tile::Id { 3, { 4, 5 } }));
+        for (const auto& id : cut.leaves())
+            CHECK((id.zoom_level <= 3 || !in_subtree(id)));
+
+        cut.update(camera, decorator, 2, 256, reject_subtree);
+        CHECK(cut.n_evaluated() == 1); // the rejected tile
+
+        cut.update(camera, decorator, 2, 256, accept_all);
+        CHECK(cut.inner_nodes().contains(tile::Id { 3, { 4, 5 } }));
+        CHECK(cut.inner_nodes() == full_traversal(camera, decorator, 2).inner_nodes);
+    }
+}
+
+TEST_CASE("nucleus/tile_scheduler/quad tree cut benchmarks")
+{
+    const auto decorator = height_data_decorator();
+    const auto path = orbit_path();
+
+    BENCHMARK("full traversal along an orbit (" + std::to_string(path.size()) + " cameras)")
+    {
+        size_t n_leaves = 0;
+        for (const auto& camera : path)
+            n_leaves += full_traversal(camera, decorator, 2).leaves.size();
+        return n_leaves;
+    };
+
+    BENCHMARK("persistent cut along an orbit (" + std::to_string(path.size()) + " cameras)")
+    {
+        QuadTreeCut cut;
+        size_t n_leaves = 0;
+        for (const auto& camera : path) {
+            cut.update(camera, decorator, 2);
+            n_leaves += cut.leaves().size();
+        }
+        return n_leaves;
+    };
+}
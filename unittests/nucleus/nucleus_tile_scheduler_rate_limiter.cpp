@@ -225,5 +225,69 @@ TEST_CASE("nucleus/tile_scheduler/rate limiter")
             }
         }
     }
+
+    SECTION("adaptive rate grows while requests queue up and backs off on errors")
+    {
+        using Status = tile_types::NetworkInfo::Status;
+        const auto quad = [](unsigned zoom_level, Status status) {
+            tile_types::TileQuad quad;
+            quad.id = tile::Id { zoom_level, { 0, 0 } };
+            quad.n_tiles = 4;
+            for (auto& tile : quad.tiles)
+                tile.network_info = { status, utils::time_since_epoch() };
+            return quad;
+        };
+        RateLimiter rl;
+        rl.set_limit(4, 2 * timing_multiplicator);
+        rl.set_adaptive(true);
+        rl.set_adaptive_bounds(2, 12);
+        QSignalSpy requested_spy(&rl, &RateLimiter::quad_requested);
+        QSignalSpy rate_spy(&rl, &RateLimiter::rate_changed);
+        for (unsigned i = 0; i < 10; ++i)
+            rl.request_quad(tile::Id { i, { 0, 0 } });
+        CHECK(requested_spy.size() == 4);
+        CHECK(rl.queue_size() == 6);
+
+        rl.receive_quad(quad(0, Status::Good));
+        REQUIRE(rate_spy.size() == 1);
+        CHECK(rl.limit().first == 12); // bounded
+        CHECK(requested_spy.size() == 10);
+        CHECK(rl.queue_size() == 0);
+
+        rl.receive_quad(quad(1, Status::NetworkError));
+        CHECK(rl.limit().first == 12); // at most one change per period
+
+        test_helpers::process_events_for(3 * timing_multiplicator);
+        rl.receive_quad(quad(2, Status::NetworkError));
+        CHECK(rl.limit().first == 6);
+
+        test_helpers::process_events_for(3 * timing_multiplicator);
+        rl.receive_quad(quad(3, Status::NetworkError));
+        CHECK(rl.limit().first == 3);
+
+        test_helpers::process_events_for(3 * timing_multiplicator);
+        rl.request_quad(tile::Id { 20, { 0, 0 } });
+        rl.receive_quad(quad(20, Status::Good));
+        CHECK(rl.limit().first == 3); // nothing queued, the rate is not the bottleneck
+
+        rl.receive_quad(quad(20, Status::NetworkError)); // already received
+        test_helpers::process_events_for(3 * timing_multiplicator);
+        rl.receive_quad(quad(5, Status::NetworkError));
+        CHECK(rl.limit().first == 2); // bounded
+        CHECK(rate_spy.size() == 4);
+    }
+
+    SECTION("the rate is fixed unless adaptive")
+    {
+        RateLimiter rl;
+        rl.set_limit(4, 2 * timing_multiplicator);
+        rl.request_quad(tile::Id { 0, { 0, 0 } });
+        tile_types::TileQuad quad;
+        quad.id = tile::Id { 0, { 0, 0 } };
+        for (auto& tile : quad.tiles)
+            tile.network_info = { tile_types::NetworkInfo::Status::NetworkError, utils::time_since_epoch() };
+        rl.receive_quad(quad);
+        CHECK(rl.limit().first == 4);
+    }
 }
 #endif
@@ -21,11 +21,16 @@
 #include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
 #include <QSignalSpy>
+#include <QTest>
 #include <QThread>
 
 #include "catch2_helpers.h"
+#include "nucleus/camera/LinearCameraAnimation.h"
 #include "nucleus/camera/PositionStorage.h"
+#include "nucleus/tile_scheduler/DiskCacheWriter.h"
+#include "nucleus/tile_scheduler/LayerAssembler.h"
 #include "nucleus/tile_scheduler/Scheduler.h"
+#include "nucleus/tile_scheduler/SlotLimiter.h"
 #include "nucleus/tile_scheduler/tile_types.h"
 #include "nucleus/tile_scheduler/utils.h"
 #include "nucleus/utils/tile_conversion.h"
@@ -49,6 +54,14 @@ constexpr auto timing_multiplicator = 1;
 constexpr auto timing_multiplicator = 1;
 #endif
 
+// with threading, quads are decoded on the pool and sent from the event loop
+void update_gpu_quads_and_wait(Scheduler* scheduler)
+{
+    scheduler->update_gpu_quads();
+    const auto done = QTest::qWaitFor([scheduler]() { return scheduler->n_pending_gpu_updates() == 0; }, 10000);
+    REQUIRE(done);
+}
+
 std::unique_ptr<Scheduler> scheduler_with_true_heights()
 {
     static auto ortho_tile = Scheduler::white_jpeg_tile(256);
@@ -302,6 +315,28 @@ TEST_CASE("nucleus/tile_scheduler/Scheduler")
               == quads.end());
     }
 
+    SECTION("quads are requested coarse first, then by screen space error")
+    {
+        auto scheduler = scheduler_with_true_heights();
+        QSignalSpy spy(scheduler.get(), &Scheduler::quads_requested);
+        auto camera = nucleus::camera::stored_positions::grossglockner();
+        camera.set_viewport_size({ 1920, 1080 });
+        scheduler->update_camera(camera);
+        scheduler->send_quad_requests();
+        REQUIRE(spy.size() == 1);
+        const auto quads = spy.constFirst().constFirst().value<std::vector<tile::Id>>();
+        REQUIRE(quads.size() >= 10);
+
+        QFile file(":/map/height_data.atb");
+        REQUIRE(file.open(QIODeviceBase::OpenModeFlag::ReadOnly));
+        const auto decorator = nucleus::tile_scheduler::utils::AabbDecorator::make(TileHeights::deserialise(file.readAll()));
+        const auto priority = nucleus::tile_scheduler::utils::request_priority_functor(camera, decorator);
+        for (size_t i = 1; i < quads.size(); ++i) {
+            CHECK(!(priority(quads[i]) < priority(quads[i - 1])));
+            CHECK(quads[i - 1].zoom_level <= quads[i].zoom_level);
+        }
+    }
+
     SECTION("quads are not requested if there is no network")
     {
         auto scheduler = default_scheduler();
@@ -341,10 +376,19 @@ TEST_CASE("nucleus/tile_scheduler/Scheduler")
 
     SECTION("network failed tiles are ignored, not found tiles are not ignored")
     {
+        // the children on the way to stephansdom exist, otherwise their subtrees would not be requested at all.
+        const auto partially_missing_quad = [](const tile::Id& id, const tile::Id& existing_child) {
+            auto quad = example_tile_quad_for(id, 4, NetworkInfo::Status::NotFound);
+            for (auto& tile : quad.tiles) {
+                if (tile.id == existing_child)
+                    tile.network_info.status = NetworkInfo::Status::Good;
+            }
+            return quad;
+        };
         auto scheduler = default_scheduler();
-        scheduler->receive_quad(example_tile_quad_for(tile::Id { 0, { 0, 0 } }, 4, NetworkInfo::Status::NotFound));
+        scheduler->receive_quad(partially_missing_quad(tile::Id { 0, { 0, 0 } }, tile::Id { 1, { 1, 1 } }));
         scheduler->receive_quad(example_tile_quad_for(tile::Id { 1, { 1, 1 } }, 4, NetworkInfo::Status::NetworkError));
-        scheduler->receive_quad(example_tile_quad_for(tile::Id { 2, { 2, 2 } }, 4, NetworkInfo::Status::NotFound));
+        scheduler->receive_quad(partially_missing_quad(tile::Id { 2, { 2, 2 } }, tile::Id { 3, { 4, 5 } }));
         scheduler->receive_quad(example_tile_quad_for(tile::Id { 3, { 4, 5 } }, 4, NetworkInfo::Status::NetworkError));
         QSignalSpy spy(scheduler.get(), &Scheduler::quads_requested);
         scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
@@ -364,6 +408,295 @@ TEST_CASE("nucleus/tile_scheduler/Scheduler")
         CHECK(std::find(quads.cbegin(), quads.cend(), tile::Id { 4, { 8, 10 } }) != quads.end());
     }
 
+    SECTION("subtrees of missing tiles are neither refined nor requested")
+    {
+        auto scheduler = default_scheduler();
+        Scheduler::Statistics statistics;
+        QObject::connect(scheduler.get(), &Scheduler::statistics_updated, [&statistics](Scheduler::Statistics s) { statistics = s; });
+        QSignalSpy spy(scheduler.get(), &Scheduler::quads_requested);
+        scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+        scheduler->receive_quad(example_tile_quad_for(tile::Id { 2, { 2, 2 } }, 4, NetworkInfo::Status::NotFound));
+        CHECK(!scheduler->availability().available(tile::Id { 3, { 4, 5 } }));
+        CHECK(!scheduler->availability().available(tile::Id { 10, { 4 * 128 + 3, 5 * 128 + 7 } }));
+        CHECK(scheduler->availability().available(tile::Id { 2, { 2, 2 } }));
+        CHECK(statistics.n_unavailable_subtrees == 4);
+
+        scheduler->send_quad_requests();
+        REQUIRE(spy.size() == 1);
+        const auto quads = spy.constFirst().constFirst().value<std::vector<tile::Id>>();
+        CHECK(std::find(quads.cbegin(), quads.cend(), tile::Id { 1, { 1, 1 } }) != quads.end());
+        for (const auto& id : quads) {
+            const auto in_missing_subtree = id.zoom_level >= 3 && (id.coords.x >> (id.zoom_level - 2)) == 2 && (id.coords.y >> (id.zoom_level - 2)) == 2;
+            CHECK(!in_missing_subtree);
+        }
+    }
+
+    SECTION("a tile with only one layer missing is unavailable, its other layer can't be shown on its own")
+    {
+        auto scheduler = default_scheduler();
+        QSignalSpy spy(scheduler.get(), &Scheduler::quads_requested);
+        scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+        auto quad = example_tile_quad_for(tile::Id { 2, { 2, 2 } });
+        const auto missing_id = tile::Id { 3, { 4, 5 } };
+        auto& tile = *std::find_if(quad.tiles.begin(), quad.tiles.end(), [&](const auto& t) { return t.id == missing_id; });
+        const auto now = nucleus::tile_scheduler::utils::time_since_epoch();
+        tile = nucleus::tile_scheduler::LayerAssembler::join({ missing_id, { NetworkInfo::Status::NotFound, now }, std::make_shared<QByteArray>() },
+            { missing_id, { NetworkInfo::Status::Good, now }, tile.height });
+        REQUIRE(tile.network_info.status == NetworkInfo::Status::NotFound);
+        REQUIRE(tile.height->isEmpty()); // the heights are dropped together with the missing ortho photo
+        scheduler->receive_quad(quad);
+        CHECK(!scheduler->availability().available(missing_id));
+        CHECK(scheduler->availability().available(tile::Id { 3, { 4, 4 } }));
+
+        scheduler->send_quad_requests();
+        REQUIRE(spy.size() == 1);
+        const auto quads = spy.constFirst().constFirst().value<std::vector<tile::Id>>();
+        for (const auto& id : quads) {
+            const auto in_missing_subtree = id.zoom_level >= 4 && (id.coords.x >> (id.zoom_level - 3)) == 4 && (id.coords.y >> (id.zoom_level - 3)) == 5;
+            CHECK(!in_missing_subtree);
+        }
+    }
+
+#ifndef __EMSCRIPTEN__
+    SECTION("quads with network errors are retried with backoff")
+    {
+        auto scheduler = default_scheduler();
+        scheduler->set_retry_backoff(1'000'000, 1'000'000);
+        Scheduler::Statistics statistics;
+        QObject::connect(scheduler.get(), &Scheduler::statistics_updated, [&statistics](Scheduler::Statistics s) { statistics = s; });
+        QSignalSpy spy(scheduler.get(), &Scheduler::quads_requested);
+        scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+        const auto failing_id = tile::Id { 3, { 4, 5 } };
+        const auto requested = [&spy, &failing_id]() {
+            const auto quads = spy.constLast().constFirst().value<std::vector<tile::Id>>();
+            return std::find(quads.cbegin(), quads.cend(), failing_id) != quads.cend();
+        };
+
+        scheduler->receive_quad(example_tile_quad_for(failing_id, 4, NetworkInfo::Status::NetworkError));
+        CHECK(statistics.n_quads_awaiting_retry == 1);
+        scheduler->send_quad_requests();
+        CHECK(requested()); // the first retry goes out right away
+
+        scheduler->receive_quad(example_tile_quad_for(failing_id, 4, NetworkInfo::Status::NetworkError));
+        scheduler->send_quad_requests();
+        CHECK(!requested()); // backing off
+        CHECK(statistics.n_retries == 1);
+        CHECK(statistics.n_quads_awaiting_retry == 1);
+
+        scheduler->receive_quad(example_tile_quad_for(failing_id, 4, NetworkInfo::Status::Good));
+        CHECK(statistics.n_quads_awaiting_retry == 0);
+        CHECK(statistics.n_recovered_quads == 1);
+        CHECK(statistics.mean_time_to_recovery < 10'000);
+    }
+
+    SECTION("quads are requested again once their backoff elapsed")
+    {
+        auto scheduler = default_scheduler();
+        scheduler->set_retry_backoff(5 * timing_multiplicator, 5 * timing_multiplicator);
+        scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+        const auto failing_id = tile::Id { 3, { 4, 5 } };
+        scheduler->receive_quad(example_tile_quad_for(failing_id, 4, NetworkInfo::Status::NetworkError));
+        scheduler->send_quad_requests();
+        scheduler->receive_quad(example_tile_quad_for(failing_id, 4, NetworkInfo::Status::NetworkError));
+
+        scheduler->set_update_timeout(1);
+        QSignalSpy spy(scheduler.get(), &Scheduler::quads_requested);
+        test_helpers::process_events_for(10 * timing_multiplicator);
+        REQUIRE(spy.size() >= 1);
+        const auto quads = spy.constLast().constFirst().value<std::vector<tile::Id>>();
+        CHECK(std::find(quads.cbegin(), quads.cend(), failing_id) != quads.cend());
+    }
+
+    SECTION("retries are limited by a global budget")
+    {
+        auto scheduler = default_scheduler();
+        scheduler->set_retry_budget(1, 1'000'000);
+        QSignalSpy spy(scheduler.get(), &Scheduler::quads_requested);
+        scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+        scheduler->receive_quad(example_tile_quad_for(tile::Id { 1, { 1, 1 } }, 4, NetworkInfo::Status::NetworkError));
+        scheduler->receive_quad(example_tile_quad_for(tile::Id { 3, { 4, 5 } }, 4, NetworkInfo::Status::NetworkError));
+        scheduler->send_quad_requests();
+        REQUIRE(spy.size() == 1);
+        const auto quads = spy.constFirst().constFirst().value<std::vector<tile::Id>>();
+        const auto n_retried = std::count(quads.cbegin(), quads.cend(), tile::Id { 1, { 1, 1 } }) + std::count(quads.cbegin(), quads.cend(), tile::Id { 3, { 4, 5 } });
+        CHECK(n_retried == 1);
+    }
+
+    SECTION("prefetch retries that are cut off don't take from the retry budget")
+    {
+        auto scheduler = default_scheduler();
+        QSignalSpy spy(scheduler.get(), &Scheduler::quads_requested);
+        scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+        scheduler->send_quad_requests();
+        const auto on_screen = spy.constLast().constFirst().value<std::vector<tile::Id>>();
+        scheduler->set_prefetch_bandwidth_share(1.f);
+        scheduler->update_animation_target(nucleus::camera::stored_positions::grossglockner());
+        scheduler->send_quad_requests();
+        const auto with_prefetch = spy.constLast().constFirst().value<std::vector<tile::Id>>();
+        REQUIRE(with_prefetch.size() > on_screen.size());
+        const auto prefetch_only_id = with_prefetch.back();
+        const auto on_screen_id = on_screen.front();
+
+        scheduler->set_retry_budget(1, 1'000'000);
+        scheduler->set_prefetch_bandwidth_share(0.f); // no prefetching while tiles are missing on screen
+        scheduler->receive_quad(example_tile_quad_for(prefetch_only_id, 4, NetworkInfo::Status::NetworkError));
+        scheduler->send_quad_requests();
+        auto quads = spy.constLast().constFirst().value<std::vector<tile::Id>>();
+        CHECK(std::find(quads.cbegin(), quads.cend(), prefetch_only_id) == quads.cend());
+
+        scheduler->receive_quad(example_tile_quad_for(on_screen_id, 4, NetworkInfo::Status::NetworkError));
+        scheduler->send_quad_requests();
+        quads = spy.constLast().constFirst().value<std::vector<tile::Id>>();
+        CHECK(std::find(quads.cbegin(), quads.cend(), on_screen_id) != quads.cend());
+    }
+
+    SECTION("retries that are dropped or cancelled downstream are not stuck in flight")
+    {
+        // attempts in flight are requested again without taking from the budget. new attempts need budget.
+        auto scheduler = default_scheduler();
+        scheduler->set_prefetch_enabled(false);
+        QSignalSpy spy(scheduler.get(), &Scheduler::quads_requested);
+        const auto requested = [&spy](const tile::Id& id) {
+            const auto quads = spy.constLast().constFirst().value<std::vector<tile::Id>>();
+            return std::find(quads.cbegin(), quads.cend(), id) != quads.cend();
+        };
+        scheduler->update_camera(nucleus::camera::stored_positions::grossglockner());
+        scheduler->send_quad_requests();
+        const auto elsewhere = spy.constLast().constFirst().value<std::vector<tile::Id>>();
+        scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+        scheduler->send_quad_requests();
+        const auto on_screen = spy.constLast().constFirst().value<std::vector<tile::Id>>();
+        const auto failing_id = on_screen.back();
+        REQUIRE(std::find(elsewhere.cbegin(), elsewhere.cend(), failing_id) == elsewhere.cend());
+
+        scheduler->set_retry_budget(2, 1'000'000);
+        scheduler->receive_quad(example_tile_quad_for(failing_id, 4, NetworkInfo::Status::NetworkError));
+        scheduler->send_quad_requests();
+        CHECK(requested(failing_id));
+        scheduler->send_quad_requests();
+        CHECK(requested(failing_id));
+
+        // cancelled by the slot limiter, the next request is a new attempt
+        scheduler->receive_cancellation(failing_id);
+        scheduler->send_quad_requests();
+        CHECK(requested(failing_id));
+
+        // dropped from the request list while out of view, coming back is a new attempt. the budget is used up.
+        scheduler->update_camera(nucleus::camera::stored_positions::grossglockner());
+        scheduler->send_quad_requests();
+        CHECK(!requested(failing_id));
+        scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+        scheduler->send_quad_requests();
+        CHECK(!requested(failing_id));
+    }
+#endif
+
+    SECTION("tiles at the animation target are prefetched after the ones on screen")
+    {
+        auto scheduler = default_scheduler();
+        scheduler->set_prefetch_bandwidth_share(1.f);
+        QSignalSpy spy(scheduler.get(), &Scheduler::quads_requested);
+        scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+        scheduler->send_quad_requests();
+        REQUIRE(spy.size() == 1);
+        const auto on_screen = spy.constLast().constFirst().value<std::vector<tile::Id>>();
+
+        scheduler->update_animation_target(nucleus::camera::stored_positions::grossglockner());
+        scheduler->send_quad_requests();
+        REQUIRE(spy.size() == 2);
+        const auto with_prefetch = spy.constLast().constFirst().value<std::vector<tile::Id>>();
+        REQUIRE(with_prefetch.size() > on_screen.size());
+        CHECK(std::equal(on_screen.cbegin(), on_screen.cend(), with_prefetch.cbegin()));
+        const auto unique = std::unordered_set<tile::Id, tile::Id::Hasher>(with_prefetch.cbegin(), with_prefetch.cend());
+        CHECK(unique.size() == with_prefetch.size());
+
+        // prefetch requests in flight are not cut off by a smaller share
+        scheduler->set_prefetch_bandwidth_share(0.2f);
+        scheduler->send_quad_requests();
+        REQUIRE(spy.size() == 3);
+        CHECK(spy.constLast().constFirst().value<std::vector<tile::Id>>() == with_prefetch);
+
+        scheduler->clear_animation_target();
+        scheduler->send_quad_requests();
+        REQUIRE(spy.size() == 4);
+        CHECK(spy.constLast().constFirst().value<std::vector<tile::Id>>() == on_screen);
+
+        // new ones are limited by the bandwidth share, as long as there are tiles missing on screen
+        scheduler->update_animation_target(nucleus::camera::stored_positions::grossglockner());
+        scheduler->send_quad_requests();
+        REQUIRE(spy.size() == 5);
+        const auto limited = spy.constLast().constFirst().value<std::vector<tile::Id>>();
+        CHECK(limited.size() > on_screen.size());
+        CHECK(limited.size() - on_screen.size() <= on_screen.size() / 4);
+
+        scheduler->clear_animation_target();
+        scheduler->set_prefetch_enabled(false);
+        scheduler->update_animation_target(nucleus::camera::stored_positions::grossglockner());
+        scheduler->send_quad_requests();
+        REQUIRE(spy.size() == 6);
+        CHECK(spy.constLast().constFirst().value<std::vector<tile::Id>>() == on_screen);
+    }
+
+    SECTION("prefetch requests in flight stay requested while the tiles on screen arrive")
+    {
+        auto scheduler = default_scheduler();
+        scheduler->set_prefetch_bandwidth_share(0.2f);
+        QSignalSpy spy(scheduler.get(), &Scheduler::quads_requested);
+        scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+        scheduler->send_quad_requests();
+        const auto on_screen = spy.constLast().constFirst().value<std::vector<tile::Id>>();
+        scheduler->update_animation_target(nucleus::camera::stored_positions::grossglockner());
+        scheduler->send_quad_requests();
+        const auto with_prefetch = spy.constLast().constFirst().value<std::vector<tile::Id>>();
+        REQUIRE(with_prefetch.size() > on_screen.size());
+        const auto prefetched = std::vector<tile::Id>(with_prefetch.cbegin() + ptrdiff_t(on_screen.size()), with_prefetch.cend());
+
+        // fewer tiles are missing on screen, which would make the share smaller
+        for (size_t i = 0; i < on_screen.size() / 2; ++i)
+            scheduler->receive_quad(example_tile_quad_for(on_screen[i]));
+        scheduler->send_quad_requests();
+        auto quads = spy.constLast().constFirst().value<std::vector<tile::Id>>();
+        for (const auto& id : prefetched)
+            CHECK(std::find(quads.cbegin(), quads.cend(), id) != quads.cend());
+
+        // cancelled downstream, the share applies again
+        for (const auto& id : prefetched)
+            scheduler->receive_cancellation(id);
+        scheduler->set_prefetch_bandwidth_share(0.f);
+        scheduler->send_quad_requests();
+        quads = spy.constLast().constFirst().value<std::vector<tile::Id>>();
+        for (const auto& id : prefetched)
+            CHECK(std::find(quads.cbegin(), quads.cend(), id) == quads.cend());
+    }
+
+    SECTION("tiles are prefetched along the camera movement")
+    {
+        auto scheduler = default_scheduler();
+        scheduler->set_prefetch_bandwidth_share(1.f);
+        QSignalSpy spy(scheduler.get(), &Scheduler::quads_requested);
+        auto camera = nucleus::camera::stored_positions::stephansdom();
+        scheduler->update_camera(camera);
+        scheduler->send_quad_requests();
+        REQUIRE(spy.size() == 1);
+        const auto standing = spy.constLast().constFirst().value<std::vector<tile::Id>>();
+
+        QThread::msleep(20);
+        camera.move({ 500, 0, 0 });
+        scheduler->update_camera(camera);
+        scheduler->set_prefetch_enabled(false);
+        scheduler->send_quad_requests();
+        REQUIRE(spy.size() == 2);
+        const auto on_screen = spy.constLast().constFirst().value<std::vector<tile::Id>>();
+
+        scheduler->set_prefetch_enabled(true);
+        scheduler->send_quad_requests();
+        REQUIRE(spy.size() == 3);
+        const auto moving = spy.constLast().constFirst().value<std::vector<tile::Id>>();
+        CHECK(moving.size() > on_screen.size());
+        CHECK(std::equal(on_screen.cbegin(), on_screen.cend(), moving.cbegin()));
+        CHECK(moving.size() > standing.size());
+    }
+
     SECTION("delivered tiles are requested again after they get too old")
     {
         auto scheduler = default_scheduler();
@@ -393,6 +726,87 @@ TEST_CASE("nucleus/tile_scheduler/Scheduler")
         }
     }
 
+    SECTION("expired quads are revalidated and kept if unchanged")
+    {
+        auto scheduler = default_scheduler();
+        scheduler->set_retirement_age_for_tile_cache(5 * timing_multiplicator);
+        Scheduler::Statistics statistics;
+        QObject::connect(scheduler.get(), &Scheduler::statistics_updated, [&statistics](Scheduler::Statistics s) { statistics = s; });
+        auto quad = example_tile_quad_for(tile::Id { 0, { 0, 0 } }, 4, NetworkInfo::Status::Good);
+        for (auto& tile : quad.tiles) {
+            tile.ortho_validators.etag = "\"ortho\"";
+            tile.height_validators.last_modified = "Wed, 21 Oct 2015 07:28:00 GMT";
+        }
+        scheduler->receive_quad(quad);
+
+        QSignalSpy spy(scheduler.get(), &Scheduler::revalidation_requested);
+        scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+        scheduler->send_quad_requests();
+        CHECK(spy.empty()); // still fresh
+
+        QThread::msleep(10 * timing_multiplicator);
+        scheduler->send_quad_requests();
+        REQUIRE(spy.size() == 1);
+        const auto validators = spy.constFirst().constFirst().value<std::vector<TileValidators>>();
+        REQUIRE(validators.size() == 4);
+        CHECK(validators.front().id == quad.tiles.front().id);
+        CHECK(validators.front().ortho.etag == "\"ortho\"");
+        CHECK(validators.front().height.last_modified == "Wed, 21 Oct 2015 07:28:00 GMT");
+
+        auto unchanged = quad;
+        for (auto& tile : unchanged.tiles) {
+            tile.ortho = nullptr;
+            tile.height = nullptr;
+            tile.network_info.timestamp = nucleus::tile_scheduler::utils::time_since_epoch();
+        }
+        scheduler->receive_quad(unchanged);
+        const auto cached = scheduler->ram_cache().peak_at(quad.id);
+        REQUIRE(cached);
+        CHECK(cached->network_info().timestamp == unchanged.network_info().timestamp);
+        for (unsigned i = 0; i < 4; ++i) {
+            REQUIRE(cached->tiles[i].ortho);
+            REQUIRE(cached->tiles[i].height);
+            CHECK(*cached->tiles[i].ortho == *quad.tiles[i].ortho);
+            CHECK(*cached->tiles[i].height == *quad.tiles[i].height);
+            CHECK(cached->tiles[i].ortho_validators.etag == "\"ortho\"");
+        }
+        CHECK(statistics.n_unchanged_layers == 8);
+
+        scheduler->send_quad_requests();
+        CHECK(spy.size() == 1); // fresh again
+    }
+
+    SECTION("unchanged quads are requested again if they were purged in the meantime")
+    {
+        auto scheduler = default_scheduler();
+        Scheduler::Statistics statistics;
+        QObject::connect(scheduler.get(), &Scheduler::statistics_updated, [&statistics](Scheduler::Statistics s) { statistics = s; });
+        auto unchanged = example_tile_quad_for(tile::Id { 0, { 0, 0 } }, 4, NetworkInfo::Status::Good);
+        for (auto& tile : unchanged.tiles)
+            tile.ortho = nullptr;
+        QSignalSpy revalidation_spy(scheduler.get(), &Scheduler::revalidation_requested);
+        QSignalSpy request_spy(scheduler.get(), &Scheduler::quads_requested);
+        scheduler->receive_quad(unchanged);
+        CHECK(!scheduler->ram_cache().contains(unchanged.id));
+        // not a network error, no retry statistics, backoff or budget
+        CHECK(statistics.n_retries == 0);
+        CHECK(statistics.n_quads_awaiting_retry == 0);
+
+        scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+        scheduler->send_quad_requests();
+        REQUIRE(request_spy.size() == 1);
+        const auto quads = request_spy.constFirst().constFirst().value<std::vector<tile::Id>>();
+        CHECK(std::find(quads.cbegin(), quads.cend(), unchanged.id) != quads.cend());
+        CHECK(revalidation_spy.empty()); // unconditional
+
+        scheduler->receive_quad(example_tile_quad_for(unchanged.id, 4, NetworkInfo::Status::Good));
+        CHECK(scheduler->ram_cache().contains(unchanged.id));
+        CHECK(statistics.n_retries == 0);
+        CHECK(statistics.n_quads_awaiting_retry == 0);
+        CHECK(statistics.n_recovered_quads == 0);
+        CHECK(statistics.mean_time_to_recovery == 0);
+    }
+
     SECTION("delivered quads are sent on to the gpu (with no repeat, only the ones in the tree)")
     {
         auto scheduler = default_scheduler();
@@ -441,7 +855,7 @@ TEST_CASE("nucleus/tile_scheduler/Scheduler")
             example_tile_quad_for({ 0, { 0, 0 } }, 4),
         });
         scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
-        scheduler->update_gpu_quads();
+        update_gpu_quads_and_wait(scheduler.get());
         REQUIRE(spy.size() == 1);
         const auto gpu_quads = spy.constFirst().constFirst().value<std::vector<nucleus::tile_scheduler::tile_types::GpuTileQuad>>();
         REQUIRE(gpu_quads.size() == 1);
@@ -478,7 +892,7 @@ TEST_CASE("nucleus/tile_scheduler/Scheduler")
         
         scheduler->receive_quad(quad);
         scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
-        scheduler->update_gpu_quads();
+        update_gpu_quads_and_wait(scheduler.get());
         REQUIRE(spy.size() == 1);
         const auto gpu_quads = spy.constFirst().constFirst().value<std::vector<nucleus::tile_scheduler::tile_types::GpuTileQuad>>();
         REQUIRE(gpu_quads.size() == 1);
@@ -492,6 +906,81 @@ TEST_CASE("nucleus/tile_scheduler/Scheduler")
         }
     }
 
+    SECTION("preliminary quads are shown with the parent's ortho photo and patched once complete")
+    {
+        using GpuQuads = std::vector<nucleus::tile_scheduler::tile_types::GpuTileQuad>;
+        auto scheduler = default_scheduler();
+        scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+        scheduler->receive_quad(example_tile_quad_for({ 0, { 0, 0 } }));
+        update_gpu_quads_and_wait(scheduler.get());
+
+        auto preliminary = example_tile_quad_for({ 1, { 1, 1 } });
+        for (auto& tile : preliminary.tiles)
+            tile.ortho = std::make_shared<QByteArray>();
+        QSignalSpy spy(scheduler.get(), &Scheduler::gpu_quads_updated);
+        scheduler->receive_preliminary_quad(preliminary);
+        update_gpu_quads_and_wait(scheduler.get());
+        REQUIRE(spy.size() == 1);
+        {
+            const auto gpu_quads = spy.constLast().constFirst().value<GpuQuads>();
+            REQUIRE(gpu_quads.size() == 1);
+            CHECK(gpu_quads[0].id == tile::Id { 1, { 1, 1 } });
+            for (const auto& tile : gpu_quads[0].tiles) {
+                REQUIRE(tile.ortho);
+                CHECK(tile.ortho->width() == 256);
+                CHECK(tile.ortho->height() == 256);
+            }
+        }
+        CHECK(!scheduler->decoded_cache().contains(tile::Id { 1, { 1, 1 } }));
+
+        // the request stays active
+        QSignalSpy request_spy(scheduler.get(), &Scheduler::quads_requested);
+        scheduler->send_quad_requests();
+        REQUIRE(request_spy.size() == 1);
+        const auto quads = request_spy.constFirst().constFirst().value<std::vector<tile::Id>>();
+        CHECK(std::find(quads.cbegin(), quads.cend(), tile::Id { 1, { 1, 1 } }) != quads.end());
+
+        scheduler->receive_quad(example_tile_quad_for({ 1, { 1, 1 } }));
+        update_gpu_quads_and_wait(scheduler.get());
+        REQUIRE(spy.size() == 2);
+        {
+            const auto gpu_quads = spy.constLast().constFirst().value<GpuQuads>();
+            REQUIRE(gpu_quads.size() == 1); // patched
+            CHECK(gpu_quads[0].id == tile::Id { 1, { 1, 1 } });
+            CHECK(spy.constLast().constLast().value<std::vector<tile::Id>>().empty());
+        }
+        CHECK(scheduler->decoded_cache().contains(tile::Id { 1, { 1, 1 } }));
+
+        // complete quads are not replaced with preliminary ones
+        scheduler->receive_preliminary_quad(preliminary);
+        update_gpu_quads_and_wait(scheduler.get());
+        CHECK(spy.constLast().constFirst().value<GpuQuads>().empty());
+    }
+
+    SECTION("default tiles are decoded only once")
+    {
+        auto scheduler = default_scheduler();
+        QSignalSpy spy(scheduler.get(), &Scheduler::gpu_quads_updated);
+        auto quad = example_tile_quad_for({ 0, { 0, 0 } }, 4);
+        for (auto i = 0u; i < 4; ++i) {
+            quad.tiles[i].ortho = std::make_shared<QByteArray>();
+            quad.tiles[i].height = std::make_shared<QByteArray>();
+        }
+
+        scheduler->receive_quad(quad);
+        scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+        update_gpu_quads_and_wait(scheduler.get());
+        REQUIRE(spy.size() == 1);
+        const auto gpu_quads = spy.constFirst().constFirst().value<std::vector<nucleus::tile_scheduler::tile_types::GpuTileQuad>>();
+        REQUIRE(gpu_quads.size() == 1);
+        REQUIRE(gpu_quads[0].tiles[0].ortho);
+        REQUIRE(gpu_quads[0].tiles[0].height);
+        for (auto i = 1u; i < 4; ++i) {
+            CHECK(gpu_quads[0].tiles[i].ortho == gpu_quads[0].tiles[0].ortho);
+            CHECK(gpu_quads[0].tiles[i].height == gpu_quads[0].tiles[0].height);
+        }
+    }
+
     SECTION("gpu quads are updated when serving from cache")
     {
         auto scheduler = default_scheduler();
@@ -500,14 +989,72 @@ TEST_CASE("nucleus/tile_scheduler/Scheduler")
             scheduler->receive_quad(q);
 
         scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
-        scheduler->update_gpu_quads();
+        update_gpu_quads_and_wait(scheduler.get());
         CHECK(spy.size() == 1);
 
         scheduler->update_camera(nucleus::camera::stored_positions::grossglockner());
-        scheduler->update_gpu_quads();
+        update_gpu_quads_and_wait(scheduler.get());
         CHECK(spy.size() == 2);
     }
 
+#ifdef ALP_ENABLE_THREADING
+    SECTION("gpu quads are sent in chunks, parents before children")
+    {
+        auto scheduler = default_scheduler();
+        scheduler->set_gpu_quad_limit(17);
+        scheduler->set_gpu_quad_chunk_size(5);
+        QSignalSpy spy(scheduler.get(), &Scheduler::gpu_quads_updated);
+        for (const auto& q : example_quads_for_steffl_and_gg())
+            scheduler->receive_quad(q);
+        scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+        update_gpu_quads_and_wait(scheduler.get());
+        // depending on timing, several chunks can become ready at once
+        REQUIRE(!spy.empty());
+        REQUIRE(spy.size() <= 4);
+
+        std::unordered_set<tile::Id, tile::Id::Hasher> sent;
+        for (int i = 0; i < spy.size(); ++i) {
+            const auto new_quads = spy[i][0].value<std::vector<nucleus::tile_scheduler::tile_types::GpuTileQuad>>();
+            if (i + 1 < spy.size())
+                CHECK(new_quads.size() >= 5);
+            for (const auto& quad : new_quads) {
+                CHECK(quad.tiles[0].ortho);
+                if (quad.id.zoom_level > 0)
+                    CHECK(sent.contains(quad.id.parent()));
+                sent.insert(quad.id);
+            }
+        }
+        CHECK(sent.size() == 17);
+    }
+
+    SECTION("gpu updates don't wait for decoding, and are sent in order")
+    {
+        using GpuQuads = std::vector<nucleus::tile_scheduler::tile_types::GpuTileQuad>;
+        auto scheduler = default_scheduler();
+        scheduler->set_gpu_quad_limit(17);
+        QSignalSpy spy(scheduler.get(), &Scheduler::gpu_quads_updated);
+        for (const auto& q : example_quads_for_steffl_and_gg())
+            scheduler->receive_quad(q);
+        scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+        scheduler->update_gpu_quads();
+        CHECK(spy.empty()); // results are posted back to the event loop
+        CHECK(scheduler->n_pending_gpu_updates() == 1);
+        scheduler->update_camera(nucleus::camera::stored_positions::grossglockner());
+        update_gpu_quads_and_wait(scheduler.get());
+        REQUIRE(spy.size() == 2);
+
+        // the second update deletes quads of the first one, they must have been added before.
+        std::unordered_set<tile::Id, tile::Id::Hasher> on_gpu;
+        for (const auto& update : spy) {
+            for (const auto& id : update[1].value<std::vector<tile::Id>>())
+                CHECK(on_gpu.erase(id) == 1);
+            for (const auto& gpu_quad : update[0].value<GpuQuads>())
+                CHECK(on_gpu.insert(gpu_quad.id).second);
+        }
+        CHECK(on_gpu.size() <= 17);
+    }
+#endif
+
     SECTION("number of gpu quads doesn't exceede the limit")
     {
         auto scheduler = default_scheduler();
@@ -520,7 +1067,7 @@ TEST_CASE("nucleus/tile_scheduler/Scheduler")
 
         {
             scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
-            scheduler->update_gpu_quads();
+            update_gpu_quads_and_wait(scheduler.get());
             REQUIRE(spy.size() == 1);
             const auto new_quads = spy[0][0].value<std::vector<nucleus::tile_scheduler::tile_types::GpuTileQuad>>();
             const auto deleted_quads = spy[0][1].value<std::vector<tile::Id>>();
@@ -544,7 +1091,7 @@ TEST_CASE("nucleus/tile_scheduler/Scheduler")
 
         {
             scheduler->update_camera(nucleus::camera::stored_positions::grossglockner());
-            scheduler->update_gpu_quads();
+            update_gpu_quads_and_wait(scheduler.get());
             REQUIRE(spy.size() == 2);
             const auto new_quads = spy[1][0].value<std::vector<nucleus::tile_scheduler::tile_types::GpuTileQuad>>();
             const auto deleted_quads = spy[1][1].value<std::vector<tile::Id>>();
@@ -579,6 +1126,137 @@ TEST_CASE("nucleus/tile_scheduler/Scheduler")
         }
     }
 
+    SECTION("quads arriving without camera changes are added incrementally, with the same result as a full update")
+    {
+        using GpuQuads = std::vector<nucleus::tile_scheduler::tile_types::GpuTileQuad>;
+        const auto on_gpu_after_streaming = [](unsigned gpu_quad_limit) {
+            auto scheduler = default_scheduler();
+            scheduler->set_gpu_quad_limit(gpu_quad_limit);
+            scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+            update_gpu_quads_and_wait(scheduler.get());
+            QSignalSpy spy(scheduler.get(), &Scheduler::gpu_quads_updated);
+            auto quads = example_quads_for_steffl_and_gg();
+            for (auto i = 0u; i + 1 < quads.size(); i += 2)
+                std::swap(quads[i], quads[i + 1]); // some quads arrive before their parents
+            std::unordered_set<tile::Id, tile::Id::Hasher> on_gpu;
+            for (const auto& quad : quads) {
+                const auto n_updates = spy.size();
+                scheduler->receive_quad(quad);
+                update_gpu_quads_and_wait(scheduler.get());
+                for (auto i = n_updates; i < spy.size(); ++i) {
+                    for (const auto& id : spy[i][1].value<std::vector<tile::Id>>())
+                        CHECK(on_gpu.erase(id) == 1);
+                    for (const auto& gpu_quad : spy[i][0].value<GpuQuads>())
+                        CHECK(on_gpu.insert(gpu_quad.id).second);
+                }
+                CHECK(on_gpu.size() <= gpu_quad_limit);
+            }
+            return on_gpu;
+        };
+        const auto on_gpu_after_full_update = [](unsigned gpu_quad_limit) {
+            auto scheduler = default_scheduler();
+            scheduler->set_gpu_quad_limit(gpu_quad_limit);
+            QSignalSpy spy(scheduler.get(), &Scheduler::gpu_quads_updated);
+            for (const auto& quad : example_quads_for_steffl_and_gg())
+                scheduler->receive_quad(quad);
+            scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+            update_gpu_quads_and_wait(scheduler.get());
+            std::unordered_set<tile::Id, tile::Id::Hasher> on_gpu;
+            for (const auto& update : spy) {
+                for (const auto& gpu_quad : update[0].value<GpuQuads>())
+                    on_gpu.insert(gpu_quad.id);
+            }
+            return on_gpu;
+        };
+
+        const auto streamed = on_gpu_after_streaming(1000);
+        CHECK(streamed.size() > 10);
+        CHECK(streamed == on_gpu_after_full_update(1000));
+
+        // with a tight limit, quads are still reachable from the root (parents are not purged before their children)
+        const auto limited = on_gpu_after_streaming(8);
+        CHECK(limited.size() == 8);
+        nucleus::tile_scheduler::Cache<nucleus::tile_scheduler::tile_types::GpuCacheInfo> test_cache;
+        for (const auto& id : limited)
+            test_cache.insert({ { id } });
+        auto n_tiles = 0u;
+        test_cache.visit([&n_tiles](const auto&) {
+            n_tiles++;
+            return true;
+        });
+        CHECK(n_tiles == 8);
+    }
+
+    SECTION("quads re-entering the gpu are taken from the decoded cache")
+    {
+        using GpuQuads = std::vector<nucleus::tile_scheduler::tile_types::GpuTileQuad>;
+        auto scheduler = default_scheduler();
+        scheduler->set_gpu_quad_limit(17);
+        QSignalSpy spy(scheduler.get(), &Scheduler::gpu_quads_updated);
+        for (const auto& q : example_quads_for_steffl_and_gg())
+            scheduler->receive_quad(q);
+        const auto collect = [&spy]() {
+            GpuQuads quads;
+            for (const auto& emission : spy) {
+                const auto new_quads = emission[0].value<GpuQuads>();
+                quads.insert(quads.end(), new_quads.cbegin(), new_quads.cend());
+            }
+            spy.clear();
+            return quads;
+        };
+
+        scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+        update_gpu_quads_and_wait(scheduler.get());
+        const auto first_quads = collect();
+        REQUIRE(first_quads.size() == 17);
+
+        scheduler->update_camera(nucleus::camera::stored_positions::grossglockner());
+        update_gpu_quads_and_wait(scheduler.get());
+        collect();
+
+        scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+        update_gpu_quads_and_wait(scheduler.get());
+        const auto second_quads = collect();
+        REQUIRE(!second_quads.empty());
+        auto n_reused = 0;
+        for (const auto& quad : second_quads) {
+            const auto first = std::find_if(first_quads.cbegin(), first_quads.cend(), [&](const auto& q) { return q.id == quad.id; });
+            if (first == first_quads.cend())
+                continue;
+            CHECK(first->tiles[0].ortho == quad.tiles[0].ortho); // same texture, i.e., not decoded again
+            CHECK(first->tiles[3].height == quad.tiles[3].height);
+            ++n_reused;
+        }
+        CHECK(n_reused > 0);
+
+        // a newly received quad replaces the decoded one
+        const auto id = second_quads.front().id;
+        scheduler->receive_quad(example_tile_quad_for(id));
+        scheduler->set_gpu_quad_limit(0);
+        update_gpu_quads_and_wait(scheduler.get());
+        scheduler->set_gpu_quad_limit(17);
+        spy.clear();
+        update_gpu_quads_and_wait(scheduler.get());
+        const auto third_quads = collect();
+        const auto refreshed = std::find_if(third_quads.cbegin(), third_quads.cend(), [&](const auto& q) { return q.id == id; });
+        REQUIRE(refreshed != third_quads.cend());
+        CHECK(refreshed->tiles[0].ortho != second_quads.front().tiles[0].ortho);
+    }
+
+    SECTION("the decoded cache respects its byte limit")
+    {
+        auto scheduler = default_scheduler();
+        scheduler->set_decoded_byte_limit(1);
+        Scheduler::Statistics statistics;
+        QObject::connect(scheduler.get(), &Scheduler::statistics_updated, [&statistics](Scheduler::Statistics s) { statistics = s; });
+        for (const auto& q : example_quads_for_steffl_and_gg())
+            scheduler->receive_quad(q);
+        scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+        update_gpu_quads_and_wait(scheduler.get());
+        CHECK(statistics.n_tiles_in_gpu_cache > 0);
+        CHECK(statistics.n_bytes_in_decoded_cache == 0);
+    }
+
     SECTION("gpu tiles are optimised for the current camera position")
     {
         auto scheduler = default_scheduler();
@@ -589,7 +1267,7 @@ TEST_CASE("nucleus/tile_scheduler/Scheduler")
 
         std::unordered_set<tile::Id, tile::Id::Hasher> cached_tiles;
         scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
-        scheduler->update_gpu_quads();
+        update_gpu_quads_and_wait(scheduler.get());
         REQUIRE(spy.size() == 1);
         const auto new_quads = spy[0][0].value<std::vector<nucleus::tile_scheduler::tile_types::GpuTileQuad>>();
         for (const auto& tile : new_quads) {
@@ -613,6 +1291,24 @@ TEST_CASE("nucleus/tile_scheduler/Scheduler")
         CHECK(scheduler->ram_cache().n_cached_objects() == 17);
     }
 
+    SECTION("ram tiles are purged when the byte limit is exceeded")
+    {
+        auto scheduler = default_scheduler();
+        Scheduler::Statistics statistics;
+        QObject::connect(scheduler.get(), &Scheduler::statistics_updated, [&statistics](Scheduler::Statistics s) { statistics = s; });
+        for (const auto& q : example_quads_for_steffl_and_gg())
+            scheduler->receive_quad(q);
+        const auto n_bytes = scheduler->ram_cache().n_bytes();
+        CHECK(n_bytes > example_quads_for_steffl_and_gg().size() * sizeof(nucleus::tile_scheduler::tile_types::TileQuad));
+        CHECK(statistics.n_bytes_in_ram_cache == n_bytes);
+
+        scheduler->set_ram_byte_limit(n_bytes / 2);
+        scheduler->purge_ram_cache();
+        CHECK(scheduler->ram_cache().n_bytes() <= n_bytes / 2);
+        CHECK(scheduler->ram_cache().n_bytes() > n_bytes / 4);
+        CHECK(scheduler->ram_cache().n_cached_objects() < example_quads_for_steffl_and_gg().size());
+    }
+
     SECTION("purging tiles based on camera")
     {
         auto scheduler = default_scheduler();
@@ -679,13 +1375,14 @@ TEST_CASE("nucleus/tile_scheduler/Scheduler")
 
     const auto check_persisted_tile = [](const auto& scheduler, const tile::Id& id) {
         const auto example_quad = example_tile_quad_for(id);
-        REQUIRE(scheduler->ram_cache().contains(id));
-        REQUIRE(scheduler->ram_cache().peak_at(id).n_tiles == example_quad.n_tiles);
-        REQUIRE(scheduler->ram_cache().peak_at(id).id == id);
+        const auto quad = scheduler->ram_cache().peak_at(id);
+        REQUIRE(quad);
+        REQUIRE(quad->n_tiles == example_quad.n_tiles);
+        REQUIRE(quad->id == id);
         REQUIRE(id == example_quad.id);
         const auto children = id.children();
         for (unsigned i = 0; i < 4; ++i) {
-            const nucleus::tile_scheduler::tile_types::LayeredTile& child_tile = scheduler->ram_cache().peak_at(id).tiles[i];
+            const nucleus::tile_scheduler::tile_types::LayeredTile& child_tile = quad->tiles[i];
             CHECK(child_tile.id == children[i]);
             CHECK(*child_tile.height == *example_quad.tiles[i].height);
             CHECK(*child_tile.ortho == *example_quad.tiles[i].ortho);
@@ -711,20 +1408,99 @@ TEST_CASE("nucleus/tile_scheduler/Scheduler")
 
         check_persited_tiles(scheduler, std::vector { tile::Id { 0, { 0, 0 } }, tile::Id { 1, { 1, 1 } }, tile::Id { 2, { 2, 2 } } });
 
-        CHECK(scheduler->ram_cache().peak_at(tile::Id { 0, { 0, 0 } }).tiles[0].id == tile::Id { 1, { 0, 0 } }); // order does not matter!
-        CHECK(scheduler->ram_cache().peak_at(tile::Id { 0, { 0, 0 } }).tiles[1].id == tile::Id { 1, { 1, 0 } });
-        CHECK(scheduler->ram_cache().peak_at(tile::Id { 0, { 0, 0 } }).tiles[2].id == tile::Id { 1, { 0, 1 } });
-        CHECK(scheduler->ram_cache().peak_at(tile::Id { 0, { 0, 0 } }).tiles[3].id == tile::Id { 1, { 1, 1 } });
+        CHECK(scheduler->ram_cache().peak_at(tile::Id { 0, { 0, 0 } })->tiles[0].id == tile::Id { 1, { 0, 0 } }); // order does not matter!
+        CHECK(scheduler->ram_cache().peak_at(tile::Id { 0, { 0, 0 } })->tiles[1].id == tile::Id { 1, { 1, 0 } });
+        CHECK(scheduler->ram_cache().peak_at(tile::Id { 0, { 0, 0 } })->tiles[2].id == tile::Id { 1, { 0, 1 } });
+        CHECK(scheduler->ram_cache().peak_at(tile::Id { 0, { 0, 0 } })->tiles[3].id == tile::Id { 1, { 1, 1 } });
+
+        CHECK(scheduler->ram_cache().peak_at(tile::Id { 1, { 1, 1 } })->tiles[0].id == tile::Id { 2, { 2, 2 } });
+        CHECK(scheduler->ram_cache().peak_at(tile::Id { 1, { 1, 1 } })->tiles[1].id == tile::Id { 2, { 3, 2 } });
+        CHECK(scheduler->ram_cache().peak_at(tile::Id { 1, { 1, 1 } })->tiles[2].id == tile::Id { 2, { 2, 3 } });
+        CHECK(scheduler->ram_cache().peak_at(tile::Id { 1, { 1, 1 } })->tiles[3].id == tile::Id { 2, { 3, 3 } });
+
+        CHECK(scheduler->ram_cache().peak_at(tile::Id { 2, { 2, 2 } })->tiles[0].id == tile::Id { 3, { 4, 4 } });
+        CHECK(scheduler->ram_cache().peak_at(tile::Id { 2, { 2, 2 } })->tiles[1].id == tile::Id { 3, { 5, 4 } });
+        CHECK(scheduler->ram_cache().peak_at(tile::Id { 2, { 2, 2 } })->tiles[2].id == tile::Id { 3, { 4, 5 } });
+        CHECK(scheduler->ram_cache().peak_at(tile::Id { 2, { 2, 2 } })->tiles[3].id == tile::Id { 3, { 5, 5 } });
+        std::filesystem::remove_all(Scheduler::disk_cache_path());
+    }
 
-        CHECK(scheduler->ram_cache().peak_at(tile::Id { 1, { 1, 1 } }).tiles[0].id == tile::Id { 2, { 2, 2 } });
-        CHECK(scheduler->ram_cache().peak_at(tile::Id { 1, { 1, 1 } }).tiles[1].id == tile::Id { 2, { 3, 2 } });
-        CHECK(scheduler->ram_cache().peak_at(tile::Id { 1, { 1, 1 } }).tiles[2].id == tile::Id { 2, { 2, 3 } });
-        CHECK(scheduler->ram_cache().peak_at(tile::Id { 1, { 1, 1 } }).tiles[3].id == tile::Id { 2, { 3, 3 } });
+    SECTION("decoded quads are persisted and reused after a restart")
+    {
+        using GpuQuads = std::vector<nucleus::tile_scheduler::tile_types::GpuTileQuad>;
+        std::filesystem::remove_all(Scheduler::disk_cache_path());
+        GpuQuads first_quads;
+        {
+            auto scheduler = default_scheduler();
+            scheduler->set_decoded_disk_cache_enabled(true);
+            QSignalSpy spy(scheduler.get(), &Scheduler::gpu_quads_updated);
+            for (const auto& q : example_quads_for_steffl_and_gg())
+                scheduler->receive_quad(q);
+            scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+            update_gpu_quads_and_wait(scheduler.get());
+            for (const auto& emission : spy) {
+                const auto new_quads = emission[0].value<GpuQuads>();
+                first_quads.insert(first_quads.end(), new_quads.cbegin(), new_quads.cend());
+            }
+            scheduler->persist_tiles();
+        }
+        REQUIRE(!first_quads.empty());
 
-        CHECK(scheduler->ram_cache().peak_at(tile::Id { 2, { 2, 2 } }).tiles[0].id == tile::Id { 3, { 4, 4 } });
-        CHECK(scheduler->ram_cache().peak_at(tile::Id { 2, { 2, 2 } }).tiles[1].id == tile::Id { 3, { 5, 4 } });
-        CHECK(scheduler->ram_cache().peak_at(tile::Id { 2, { 2, 2 } }).tiles[2].id == tile::Id { 3, { 4, 5 } });
-        CHECK(scheduler->ram_cache().peak_at(tile::Id { 2, { 2, 2 } }).tiles[3].id == tile::Id { 3, { 5, 5 } });
+        auto scheduler = default_scheduler();
+        scheduler->set_decoded_disk_cache_enabled(true);
+        scheduler->read_disk_cache();
+        const auto n_decoded = scheduler->decoded_cache().n_cached_objects();
+        CHECK(n_decoded == first_quads.size());
+        CHECK(scheduler->decoded_cache().n_paged_out_objects() == n_decoded);
+
+        QSignalSpy spy(scheduler.get(), &Scheduler::gpu_quads_updated);
+        scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+        update_gpu_quads_and_wait(scheduler.get());
+        GpuQuads second_quads;
+        for (const auto& emission : spy) {
+            const auto new_quads = emission[0].value<GpuQuads>();
+            second_quads.insert(second_quads.end(), new_quads.cbegin(), new_quads.cend());
+        }
+        REQUIRE(second_quads.size() == first_quads.size());
+        for (size_t i = 0; i < first_quads.size(); ++i) {
+            CHECK(second_quads[i].id == first_quads[i].id);
+            CHECK(second_quads[i].source_timestamp == first_quads[i].source_timestamp);
+            for (unsigned j = 0; j < 4; ++j) {
+                REQUIRE(second_quads[i].tiles[j].ortho);
+                REQUIRE(second_quads[i].tiles[j].height);
+                CHECK(second_quads[i].tiles[j].ortho->format() == first_quads[i].tiles[j].ortho->format());
+                CHECK(second_quads[i].tiles[j].ortho->n_bytes() == first_quads[i].tiles[j].ortho->n_bytes());
+                CHECK(std::equal(second_quads[i].tiles[j].ortho->data(),
+                    second_quads[i].tiles[j].ortho->data() + second_quads[i].tiles[j].ortho->n_bytes(),
+                    first_quads[i].tiles[j].ortho->data()));
+                CHECK(second_quads[i].tiles[j].height->buffer() == first_quads[i].tiles[j].height->buffer());
+            }
+        }
+        std::filesystem::remove_all(Scheduler::disk_cache_path());
+    }
+
+    SECTION("decoded quads are not persisted by default")
+    {
+        std::filesystem::remove_all(Scheduler::disk_cache_path());
+        {
+            auto scheduler = default_scheduler();
+            CHECK(!scheduler->decoded_disk_cache_enabled());
+            QSignalSpy spy(scheduler.get(), &Scheduler::tiles_persisted);
+            for (const auto& q : example_quads_for_steffl_and_gg())
+                scheduler->receive_quad(q);
+            scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+            update_gpu_quads_and_wait(scheduler.get());
+            REQUIRE(scheduler->decoded_cache().n_cached_objects() > 0);
+            scheduler->persist_tiles();
+            spy.wait(10000);
+            REQUIRE(spy.size() == 1);
+        }
+        CHECK(!std::filesystem::exists(Scheduler::decoded_disk_cache_path()));
+        auto scheduler = default_scheduler();
+        scheduler->set_decoded_disk_cache_enabled(true);
+        scheduler->read_disk_cache();
+        CHECK(scheduler->ram_cache().n_cached_objects() > 0);
+        CHECK(scheduler->decoded_cache().n_cached_objects() == 0);
         std::filesystem::remove_all(Scheduler::disk_cache_path());
     }
 
@@ -751,7 +1527,7 @@ TEST_CASE("nucleus/tile_scheduler/Scheduler")
             check_persited_tiles(scheduler, std::vector { tile::Id { 0, { 0, 0 } }, tile::Id { 1, { 1, 1 } }, tile::Id { 2, { 2, 2 } }, tile::Id { 3, { 0, 0 } }, tile::Id { 4, { 0, 1 } } });
             scheduler->set_ram_quad_limit(3);
             scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
-            scheduler->update_gpu_quads();
+            update_gpu_quads_and_wait(scheduler.get());
             scheduler->purge_ram_cache();
             CHECK(scheduler->ram_cache().n_cached_objects() == 3);
             check_persited_tiles(scheduler, std::vector { tile::Id { 0, { 0, 0 } }, tile::Id { 1, { 1, 1 } }, tile::Id { 2, { 2, 2 } } });
@@ -765,6 +1541,94 @@ TEST_CASE("nucleus/tile_scheduler/Scheduler")
         std::filesystem::remove_all(Scheduler::disk_cache_path());
     }
 
+    SECTION("tile availability is written together with the tiles, on the disk cache thread")
+    {
+        std::filesystem::remove_all(Scheduler::disk_cache_path());
+        {
+            auto scheduler = default_scheduler();
+            QSignalSpy spy(scheduler.get(), &Scheduler::tiles_persisted);
+            scheduler->receive_quad(example_tile_quad_for(tile::Id { 2, { 2, 2 } }, 4, NetworkInfo::Status::NotFound));
+            scheduler->persist_tiles();
+            CHECK(!std::filesystem::exists(Scheduler::availability_path())); // the scheduler thread doesn't write
+            spy.wait(10000);
+            REQUIRE(spy.size() == 1);
+            CHECK(std::filesystem::exists(Scheduler::availability_path()));
+        }
+        auto scheduler = scheduler_with_disk_cache();
+        CHECK(!scheduler->availability().available(tile::Id { 3, { 4, 5 } }));
+        CHECK(scheduler->availability().available(tile::Id { 2, { 2, 2 } }));
+        std::filesystem::remove_all(Scheduler::disk_cache_path());
+    }
+
+    SECTION("persisted preliminary quads are replaced after a restart")
+    {
+        using GpuQuads = std::vector<nucleus::tile_scheduler::tile_types::GpuTileQuad>;
+        std::filesystem::remove_all(Scheduler::disk_cache_path());
+        {
+            auto scheduler = default_scheduler();
+            QSignalSpy spy(scheduler.get(), &Scheduler::tiles_persisted);
+            scheduler->receive_quad(example_tile_quad_for({ 0, { 0, 0 } }));
+            auto preliminary = example_tile_quad_for({ 1, { 1, 1 } });
+            for (auto& tile : preliminary.tiles)
+                tile.ortho = std::make_shared<QByteArray>();
+            scheduler->receive_preliminary_quad(preliminary);
+            scheduler->persist_tiles();
+            spy.wait(10000);
+            REQUIRE(spy.size() == 1);
+        }
+        auto scheduler = scheduler_with_disk_cache();
+        REQUIRE(scheduler->ram_cache().contains(tile::Id { 1, { 1, 1 } }));
+        CHECK(scheduler->ram_cache().peak_at(tile::Id { 1, { 1, 1 } })->preliminary);
+
+        // still requested, even though the timestamp is recent
+        scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+        QSignalSpy request_spy(scheduler.get(), &Scheduler::quads_requested);
+        scheduler->send_quad_requests();
+        REQUIRE(request_spy.size() == 1);
+        const auto quads = request_spy.constFirst().constFirst().value<std::vector<tile::Id>>();
+        CHECK(std::find(quads.cbegin(), quads.cend(), tile::Id { 1, { 1, 1 } }) != quads.end());
+
+        QSignalSpy spy(scheduler.get(), &Scheduler::gpu_quads_updated);
+        update_gpu_quads_and_wait(scheduler.get());
+        CHECK(!scheduler->decoded_cache().contains(tile::Id { 1, { 1, 1 } }));
+
+        scheduler->receive_quad(example_tile_quad_for({ 1, { 1, 1 } }));
+        update_gpu_quads_and_wait(scheduler.get());
+        REQUIRE(spy.size() == 2);
+        const auto gpu_quads = spy.constLast().constFirst().value<GpuQuads>();
+        REQUIRE(gpu_quads.size() == 1); // patched
+        CHECK(gpu_quads[0].id == tile::Id { 1, { 1, 1 } });
+        CHECK(!scheduler->ram_cache().peak_at(tile::Id { 1, { 1, 1 } })->preliminary);
+        CHECK(scheduler->decoded_cache().contains(tile::Id { 1, { 1, 1 } }));
+        std::filesystem::remove_all(Scheduler::disk_cache_path());
+    }
+
+    SECTION("persisting happens in the background, is batched and reports completion")
+    {
+        std::filesystem::remove_all(Scheduler::disk_cache_path());
+        {
+            auto scheduler = default_scheduler();
+            QSignalSpy spy(scheduler.get(), &Scheduler::tiles_persisted);
+            scheduler->receive_quad(example_tile_quad_for(tile::Id { 0, { 0, 0 } }));
+            scheduler->persist_tiles();
+            scheduler->receive_quad(example_tile_quad_for(tile::Id { 1, { 1, 1 } }));
+            scheduler->persist_tiles();
+            scheduler->receive_quad(example_tile_quad_for(tile::Id { 2, { 2, 2 } }));
+            scheduler->persist_tiles();
+            // the second and third request are batched into one write, which starts after the first one finished
+            while (spy.size() < 2 && spy.wait(5000)) { }
+            REQUIRE(spy.size() == 2);
+            CHECK(spy[0][0].toBool());
+            CHECK(spy[1][0].toBool());
+            test_helpers::process_events_for(4 * timing_multiplicator);
+            CHECK(spy.size() == 2);
+        }
+        auto scheduler = scheduler_with_disk_cache();
+        CHECK(scheduler->ram_cache().n_cached_objects() == 3);
+        check_persited_tiles(scheduler, std::vector { tile::Id { 0, { 0, 0 } }, tile::Id { 1, { 1, 1 } }, tile::Id { 2, { 2, 2 } } });
+        std::filesystem::remove_all(Scheduler::disk_cache_path());
+    }
+
     SECTION("notification, when a tile is received")
     {
         auto scheduler = default_scheduler();
@@ -811,7 +1675,7 @@ TEST_CASE("nucleus/tile_scheduler/Scheduler benchmarks")
         for (const auto& q : example_quads_for_steffl_and_gg())
             scheduler->receive_quad(q);
         // unpacking byte arrays takes long, hence only the smaller dataset
-        scheduler->update_gpu_quads();
+        update_gpu_quads_and_wait(scheduler.get());
     };
 
     BENCHMARK("receive " + std::to_string(example_quads_many().size()) + " quads + purge_ram_cache")
@@ -832,9 +1696,99 @@ TEST_CASE("nucleus/tile_scheduler/Scheduler benchmarks")
             scheduler->receive_quad(example_tile_quad_for({ i, { 1, 1 } }));
             scheduler->receive_quad(example_tile_quad_for({ i, { 0, 1 } }));
         }
-        BENCHMARK("write cache to disk") {
+        // writing happens on the disk cache thread, wait for it to finish.
+        const auto persist_and_wait = [&scheduler]() {
+            QSignalSpy spy(scheduler.get(), &Scheduler::tiles_persisted);
             scheduler->persist_tiles();
+            spy.wait(10000);
+        };
+        BENCHMARK("write cache to disk (from scratch, includes removing the old cache)")
+        {
+            std::filesystem::remove_all(Scheduler::disk_cache_path());
+            persist_and_wait();
+        };
+        BENCHMARK("write cache to disk (nothing changed)")
+        {
+            persist_and_wait();
+        };
+        // new quads at zoom level 17 (with children at 18, the deepest level that the scheduler refines to), row by row
+        unsigned n_new_quads = 0;
+        const auto new_quad_id = [&n_new_quads]() {
+            constexpr auto n_columns = 1u << 17;
+            const auto i = n_new_quads++;
+            return tile::Id { 17, { i % n_columns, i / n_columns } };
+        };
+        BENCHMARK("write cache to disk (4 new quads)")
+        {
+            for (unsigned i = 0; i < 4; ++i)
+                scheduler->receive_quad(example_tile_quad_for(new_quad_id()));
+            persist_and_wait();
         };
+        // persist_tiles only queues a call to the writer on the disk cache thread. this is the work done there, measured directly
+        // (the writer of the scheduler is idle, all its writes were awaited).
+        nucleus::tile_scheduler::DiskCacheWriter writer(&scheduler->ram_cache(), Scheduler::disk_cache_path());
+        BENCHMARK("DiskCacheWriter::write on the calling thread (4 new quads)")
+        {
+            for (unsigned i = 0; i < 4; ++i)
+                scheduler->receive_quad(example_tile_quad_for(new_quad_id()));
+            writer.write();
+        };
+    }
+
+    {
+        // fly-to from stephansdom to grossglockner against a simulated tile server with a fixed latency.
+        // measures the time until the last tile was delivered, i.e., no requests are pending anymore.
+        struct FlyToSimulation {
+            std::unique_ptr<Scheduler> scheduler;
+            std::unique_ptr<nucleus::tile_scheduler::SlotLimiter> slot_limiter;
+            explicit FlyToSimulation(bool prefetch)
+                : scheduler(scheduler_with_true_heights())
+                , slot_limiter(std::make_unique<nucleus::tile_scheduler::SlotLimiter>())
+            {
+                scheduler->set_prefetch_enabled(prefetch);
+                scheduler->set_gpu_quad_limit(64);
+                scheduler->set_update_timeout(16);
+                auto* sl = slot_limiter.get();
+                QObject::connect(scheduler.get(), &Scheduler::quads_requested, sl, &nucleus::tile_scheduler::SlotLimiter::request_quads);
+                QObject::connect(sl, &nucleus::tile_scheduler::SlotLimiter::quad_requested, sl, [sl](const tile::Id& id) {
+                    QTimer::singleShot(20, sl, [sl, id]() { sl->deliver_quad(example_tile_quad_for(id)); });
+                });
+                QObject::connect(sl, &nucleus::tile_scheduler::SlotLimiter::quad_delivered, scheduler.get(), &Scheduler::receive_quad);
+                auto start = nucleus::camera::stored_positions::stephansdom();
+                start.set_viewport_size({ 1920, 1080 });
+                scheduler->update_camera(start);
+            }
+            void run()
+            {
+                auto camera = nucleus::camera::stored_positions::stephansdom();
+                camera.set_viewport_size({ 1920, 1080 });
+                auto end_camera = nucleus::camera::stored_positions::grossglockner();
+                end_camera.set_viewport_size({ 1920, 1080 });
+                nucleus::camera::LinearCameraAnimation animation(camera, end_camera);
+                scheduler->update_animation_target(end_camera);
+                while (const auto next = animation.update(camera, nullptr)) {
+                    camera = next.value();
+                    scheduler->update_camera(camera);
+                    test_helpers::process_events_for(16);
+                }
+                scheduler->clear_animation_target();
+                // a delivery triggers new requests after the update timeout, hence idle means nothing in flight for a while.
+                unsigned idle = 0;
+                while (idle < 3) {
+                    test_helpers::process_events_for(16);
+                    idle = slot_limiter->slots_taken() == 0 ? idle + 1 : 0;
+                }
+            }
+        };
+        for (const auto prefetch : { false, true }) {
+            BENCHMARK_ADVANCED(std::string("fly-to until no requests are pending (prefetch ") + (prefetch ? "on)" : "off)"))(Catch::Benchmark::Chronometer meter)
+            {
+                std::vector<std::unique_ptr<FlyToSimulation>> simulations;
+                for (int i = 0; i < meter.runs(); ++i)
+                    simulations.push_back(std::make_unique<FlyToSimulation>(prefetch));
+                meter.measure([&simulations](int i) { simulations[size_t(i)]->run(); });
+            };
+        }
     }
 
     BENCHMARK("read cache from disk") {
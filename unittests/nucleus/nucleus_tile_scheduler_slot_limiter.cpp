@@ -60,9 +60,12 @@ TEST_CASE("nucleus/tile_scheduler/slot limiter")
         CHECK(spy[0][0].value<tile::Id>() == tile::Id { 0, { 0, 0 } });
         CHECK(spy[1][0].value<tile::Id>() == tile::Id { 1, { 0, 0 } });
 
-        sl.request_quads({ tile::Id { 1, { 1, 0 } } });
+        sl.request_quads({ tile::Id { 1, { 1, 0 } },
+            tile::Id { 1, { 0, 0 } },
+            tile::Id { 1, { 0, 1 } } });
         CHECK(sl.slots_taken() == 2);
-        CHECK(spy.size() == 2);
+        REQUIRE(spy.size() == 3);
+        CHECK(spy[2][0].value<tile::Id>() == tile::Id { 1, { 1, 0 } });
     }
 
     SECTION("receiving tiles frees up slots")
@@ -197,6 +200,63 @@ TEST_CASE("nucleus/tile_scheduler/slot limiter")
         CHECK(sl.slots_taken() == 0);
     }
 
+    SECTION("a new request list replaces the queue and its order")
+    {
+        SlotLimiter sl;
+        sl.set_limit(1);
+        QSignalSpy spy(&sl, &SlotLimiter::quad_requested);
+        sl.request_quads({ tile::Id { 0, { 0, 0 } },
+            tile::Id { 1, { 0, 0 } },
+            tile::Id { 1, { 1, 0 } },
+            tile::Id { 1, { 0, 1 } } });
+        REQUIRE(spy.size() == 1);
+
+        // e.g., the camera moved, and the priorities changed
+        sl.request_quads({ tile::Id { 1, { 0, 1 } },
+            tile::Id { 1, { 0, 0 } },
+            tile::Id { 2, { 0, 0 } } });
+        for (const auto& id : std::vector<tile::Id> { { 0, { 0, 0 } }, { 1, { 0, 1 } }, { 1, { 0, 0 } }, { 2, { 0, 0 } } })
+            sl.deliver_quad(tile_types::TileQuad { id });
+        REQUIRE(spy.size() == 4);
+        CHECK(spy[1][0].value<tile::Id>() == tile::Id { 1, { 0, 1 } });
+        CHECK(spy[2][0].value<tile::Id>() == tile::Id { 1, { 0, 0 } });
+        CHECK(spy[3][0].value<tile::Id>() == tile::Id { 2, { 0, 0 } });
+        CHECK(sl.slots_taken() == 0);
+    }
+
+    SECTION("in flight quads that are not requested anymore are cancelled and free their slots")
+    {
+        SlotLimiter sl;
+        sl.set_limit(2);
+        QSignalSpy requested_spy(&sl, &SlotLimiter::quad_requested);
+        QSignalSpy cancelled_spy(&sl, &SlotLimiter::quad_cancelled);
+        sl.request_quads({ tile::Id { 0, { 0, 0 } },
+            tile::Id { 1, { 0, 0 } },
+            tile::Id { 1, { 0, 1 } } });
+        REQUIRE(requested_spy.size() == 2);
+        CHECK(cancelled_spy.size() == 0);
+
+        // e.g., the camera jumped
+        sl.request_quads({ tile::Id { 1, { 0, 0 } },
+            tile::Id { 2, { 3, 3 } },
+            tile::Id { 2, { 3, 2 } } });
+        REQUIRE(cancelled_spy.size() == 1);
+        CHECK(cancelled_spy[0][0].value<tile::Id>() == tile::Id { 0, { 0, 0 } });
+        REQUIRE(requested_spy.size() == 3);
+        CHECK(requested_spy[2][0].value<tile::Id>() == tile::Id { 2, { 3, 3 } });
+        CHECK(sl.slots_taken() == 2);
+
+        // a late delivery of the cancelled quad doesn't take the slot of another one
+        sl.deliver_quad(tile_types::TileQuad { tile::Id { 0, { 0, 0 } } });
+        CHECK(sl.slots_taken() == 2);
+        CHECK(requested_spy.size() == 3);
+
+        sl.deliver_quad(tile_types::TileQuad { tile::Id { 1, { 0, 0 } } });
+        REQUIRE(requested_spy.size() == 4);
+        CHECK(requested_spy[3][0].value<tile::Id>() == tile::Id { 2, { 3, 2 } });
+        CHECK(sl.slots_taken() == 2);
+    }
+
     SECTION("delivered quads are sent on")
     {
         SlotLimiter sl;
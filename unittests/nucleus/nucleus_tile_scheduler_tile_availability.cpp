@@ -0,0 +1,87 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include <filesystem>
+
+#include <QStandardPaths>
+#include <QThread>
+#include <catch2/catch_test_macros.hpp>
+
+#include "nucleus/tile_scheduler/TileAvailability.h"
+#include "nucleus/tile_scheduler/utils.h"
+
+using nucleus::tile_scheduler::TileAvailability;
+
+TEST_CASE("nucleus/tile_scheduler/tile availability")
+{
+    SECTION("everything is available by default")
+    {
+        TileAvailability availability;
+        CHECK(availability.available(tile::Id { 0, { 0, 0 } }));
+        CHECK(availability.available(tile::Id { 18, { 1234, 5678 } }));
+        CHECK(availability.n_entries() == 0);
+    }
+
+    SECTION("missing tiles have no descendants")
+    {
+        TileAvailability availability;
+        availability.mark_unavailable(tile::Id { 2, { 1, 2 } });
+        CHECK(!availability.available(tile::Id { 2, { 1, 2 } }));
+        CHECK(!availability.available(tile::Id { 3, { 3, 5 } }));
+        CHECK(!availability.available(tile::Id { 12, { 1 * 1024 + 10, 2 * 1024 + 1023 } }));
+        CHECK(availability.available(tile::Id { 2, { 2, 2 } }));
+        CHECK(availability.available(tile::Id { 1, { 0, 1 } }));
+        CHECK(availability.available(tile::Id { 12, { 2 * 1024, 2 * 1024 } }));
+    }
+
+    SECTION("entries expire")
+    {
+        TileAvailability availability;
+        const auto now = nucleus::tile_scheduler::utils::time_since_epoch();
+        availability.mark_unavailable(tile::Id { 3, { 1, 2 } }, now + 20);
+        availability.mark_unavailable(tile::Id { 3, { 2, 2 } });
+        CHECK(!availability.available(tile::Id { 3, { 1, 2 } }));
+        QThread::msleep(30);
+        CHECK(availability.available(tile::Id { 3, { 1, 2 } }));
+        CHECK(!availability.available(tile::Id { 3, { 2, 2 } }));
+        CHECK(availability.n_entries() == 2);
+        availability.prune();
+        CHECK(availability.n_entries() == 1);
+    }
+
+    SECTION("writing to and reading from disk")
+    {
+        const auto path = std::filesystem::path(QStandardPaths::writableLocation(QStandardPaths::CacheLocation).toStdString()) / "test_availability.alp";
+        {
+            TileAvailability availability;
+            availability.mark_unavailable(tile::Id { 5, { 10, 20 } });
+            availability.mark_unavailable(tile::Id { 7, { 1, 2 } }, nucleus::tile_scheduler::utils::time_since_epoch() + 100'000);
+            std::filesystem::create_directories(path.parent_path());
+            REQUIRE(availability.write_to_disk(path).has_value());
+        }
+        TileAvailability availability;
+        REQUIRE(availability.read_from_disk(path).has_value());
+        CHECK(availability.n_entries() == 2);
+        CHECK(!availability.available(tile::Id { 5, { 10, 20 } }));
+        CHECK(!availability.available(tile::Id { 8, { 2, 5 } }));
+        CHECK(availability.available(tile::Id { 5, { 10, 21 } }));
+        std::filesystem::remove(path);
+
+        CHECK(!availability.read_from_disk(path).has_value());
+    }
+}
@@ -19,16 +19,26 @@
 
 #include <algorithm>
 
+#include <QNetworkAccessManager>
 #include <QRegularExpression>
 #include <QSignalSpy>
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
 
+#include "MockTileServer.h"
 #include "nucleus/tile_scheduler/TileLoadService.h"
 #include "nucleus/utils/tile_conversion.h"
 
 using namespace nucleus::tile_scheduler;
 using nucleus::tile_scheduler::tile_types::TileLayer;
 
+namespace {
+void wait_for(QSignalSpy* spy, int n_signals)
+{
+    while (spy->count() < n_signals && spy->wait(10000)) { }
+}
+}
+
 inline std::ostream& operator<<(std::ostream& os, const QString& value)
 {
     os << value.toStdString();
@@ -255,4 +265,136 @@ TEST_CASE("nucleus/tile_scheduler/TileLoadService")
         const auto image = nucleus::utils::tile_conversion::toQImage(*tile.data);
         REQUIRE(image.sizeInBytes() == 0);
     }
+
+    SECTION("cancelled tiles are not reported")
+    {
+        TileLoadService service("https://alpinemaps.cg.tuwien.ac.at/tiles/alpine_png/",
+                                TileLoadService::UrlPattern::ZYX,
+                                ".png");
+        QSignalSpy spy(&service, &TileLoadService::load_finished);
+        const tile::Id cancelled_tile_id = { .zoom_level = 0, .coords = { 0, 0 } };
+        const tile::Id other_tile_id = { .zoom_level = 1, .coords = { 0, 0 } };
+        service.load(cancelled_tile_id);
+        service.load(other_tile_id);
+        service.cancel(cancelled_tile_id);
+        service.cancel(tile::Id { .zoom_level = 5, .coords = { 3, 3 } }); // unknown tiles are ignored
+        spy.wait(10000);
+        spy.wait(100); // give the cancelled reply a chance to show up
+
+        REQUIRE(spy.count() == 1);
+        CHECK(spy.constFirst().constFirst().value<TileLayer>().id == other_tile_id);
+    }
+
+    SECTION("expired tiles are revalidated with conditional requests")
+    {
+        unittests::MockTileServer server("tile data");
+        TileLoadService service(server.base_url(), TileLoadService::UrlPattern::ZXY, ".png");
+        QSignalSpy spy(&service, &TileLoadService::load_finished);
+        const tile::Id tile_id = { .zoom_level = 3, .coords = { 2, 1 } };
+        service.load(tile_id);
+        wait_for(&spy, 1);
+        REQUIRE(spy.count() == 1);
+        const auto downloaded = spy.constLast().constFirst().value<TileLayer>();
+        REQUIRE(downloaded.data);
+        CHECK(*downloaded.data == "tile data");
+        REQUIRE(!downloaded.validators.etag.isEmpty());
+
+        service.set_validators(tile_id, downloaded.validators);
+        service.load(tile_id);
+        wait_for(&spy, 2);
+        REQUIRE(spy.count() == 2);
+        const auto revalidated = spy.constLast().constFirst().value<TileLayer>();
+        CHECK(revalidated.network_info.status == tile_types::NetworkInfo::Status::Good);
+        CHECK(!revalidated.data); // unchanged
+        CHECK(revalidated.validators.etag == downloaded.validators.etag);
+        CHECK(server.n_not_modified() == 1);
+
+        // validators are used once, and outdated ones lead to a full download
+        service.set_validators(tile_id, { .etag = "\"outdated\"", .last_modified = {} });
+        service.load(tile_id);
+        wait_for(&spy, 3);
+        service.load(tile_id);
+        wait_for(&spy, 4);
+        REQUIRE(spy.count() == 4);
+        for (int i = 2; i < 4; ++i) {
+            const auto tile = spy.at(i).constFirst().value<TileLayer>();
+            REQUIRE(tile.data);
+            CHECK(*tile.data == "tile data");
+        }
+        CHECK(server.n_not_modified() == 1);
+    }
+
+    SECTION("services can share a network manager and its connection pool")
+    {
+        unittests::MockTileServer server("tile data", 5);
+        auto network_manager = std::make_shared<QNetworkAccessManager>();
+        TileLoadService ortho_service(server.base_url() + "ortho/", TileLoadService::UrlPattern::ZXY, ".jpeg");
+        TileLoadService height_service(server.base_url() + "height/", TileLoadService::UrlPattern::ZXY, ".png");
+        ortho_service.set_network_manager(network_manager);
+        height_service.set_network_manager(network_manager);
+        // the mock server speaks http/1.1 only, the connection limit is what is tested here.
+        for (auto* service : { &ortho_service, &height_service })
+            service->set_connection_settings({ .http2_allowed = false, .http2_cleartext_allowed = false, .n_connections_per_host = 2 });
+        CHECK(ortho_service.connection_settings().n_connections_per_host == 2);
+
+        QSignalSpy ortho_spy(&ortho_service, &TileLoadService::load_finished);
+        QSignalSpy height_spy(&height_service, &TileLoadService::load_finished);
+        for (unsigned i = 0; i < 8; ++i) {
+            ortho_service.load(tile::Id { 3, { i, 0 } });
+            height_service.load(tile::Id { 3, { i, 0 } });
+        }
+        wait_for(&ortho_spy, 8);
+        wait_for(&height_spy, 8);
+        REQUIRE(ortho_spy.count() == 8);
+        REQUIRE(height_spy.count() == 8);
+        for (const auto& arguments : ortho_spy) {
+            const auto tile = arguments.constFirst().value<TileLayer>();
+            CHECK(tile.network_info.status == tile_types::NetworkInfo::Status::Good);
+            CHECK(*tile.data == "tile data");
+        }
+        CHECK(server.n_requests() == 16);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
+        CHECK(server.max_open_connections() <= 2); // one pool for both services
+#endif
+    }
+}
+
+TEST_CASE("nucleus/tile_scheduler/TileLoadService benchmarks")
+{
+    // two layers of 16 quads (128 requests) against a local server with a fixed round trip time of 20ms.
+    // quads/s = 16 / measured time. the mock server speaks http/1.1 only, so this measures the connection limits and sharing the
+    // connection pool, not http/2 multiplexing.
+    constexpr unsigned n_quads = 16;
+    constexpr unsigned round_trip_time = 20;
+    unittests::MockTileServer server(QByteArray(20'000, 'x'), round_trip_time);
+    for (const auto n_connections : { 2u, 6u, 16u }) {
+        for (const auto shared_manager : { false, true }) {
+            const auto name = std::to_string(n_quads) + " quads, rtt " + std::to_string(round_trip_time) + "ms, " + std::to_string(n_connections)
+                + " connections per host, " + (shared_manager ? "shared manager" : "manager per service");
+            BENCHMARK(name)
+            {
+                TileLoadService ortho_service(server.base_url() + "ortho/", TileLoadService::UrlPattern::ZXY, ".jpeg");
+                TileLoadService height_service(server.base_url() + "height/", TileLoadService::UrlPattern::ZXY, ".png");
+                if (shared_manager) {
+                    auto network_manager = std::make_shared<QNetworkAccessManager>();
+                    ortho_service.set_network_manager(network_manager);
+                    height_service.set_network_manager(network_manager);
+                }
+                for (auto* service : { &ortho_service, &height_service })
+                    service->set_connection_settings({ .http2_allowed = false, .http2_cleartext_allowed = false, .n_connections_per_host = n_connections });
+
+                QSignalSpy ortho_spy(&ortho_service, &TileLoadService::load_finished);
+                QSignalSpy height_spy(&height_service, &TileLoadService::load_finished);
+                for (unsigned i = 0; i < n_quads; ++i) {
+                    for (const auto& id : tile::Id { 8, { i, 0 } }.children()) {
+                        ortho_service.load(id);
+                        height_service.load(id);
+                    }
+                }
+                wait_for(&ortho_spy, int(n_quads * 4));
+                wait_for(&height_spy, int(n_quads * 4));
+                return ortho_spy.count() + height_spy.count();
+            };
+        }
+    }
 }
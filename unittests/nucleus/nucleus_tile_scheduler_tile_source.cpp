@@ -0,0 +1,212 @@
+/*****************************************************************************
+ * Alpine Terrain Renderer
+ * Copyright (C) 2023 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include <algorithm>
+#include <tuple>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSignalSpy>
+#include <QTest>
+#ifdef ALP_ENABLE_MBTILES
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#endif
+#include <QTemporaryDir>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "nucleus/tile_scheduler/DirectoryTileSource.h"
+#ifdef ALP_ENABLE_MBTILES
+#include "nucleus/tile_scheduler/MbTilesTileSource.h"
+#endif
+
+using namespace nucleus::tile_scheduler;
+using nucleus::tile_scheduler::tile_types::TileLayer;
+
+namespace {
+QByteArray tile_data(const tile::Id& id) { return QString("tile %1 %2 %3").arg(id.zoom_level).arg(id.coords.x).arg(id.coords.y).toUtf8(); }
+
+std::vector<tile::Id> tile_ids(unsigned zoom_level)
+{
+    std::vector<tile::Id> ids;
+    const auto n = 1u << zoom_level;
+    for (unsigned x = 0; x < n; ++x) {
+        for (unsigned y = 0; y < n; ++y)
+            ids.push_back({ zoom_level, { x, y } });
+    }
+    return ids;
+}
+
+void write_directory(const QString& directory, const std::vector<tile::Id>& ids)
+{
+    for (const auto& id : ids) {
+        const auto path = directory + "/" + TileSource::tile_address(id, TileSource::UrlPattern::ZXY) + ".png";
+        QDir().mkpath(QFileInfo(path).path());
+        QFile file(path);
+        REQUIRE(file.open(QIODeviceBase::WriteOnly));
+        file.write(tile_data(id));
+    }
+}
+
+#ifdef ALP_ENABLE_MBTILES
+void write_mbtiles(const QString& path, const std::vector<tile::Id>& ids)
+{
+    {
+        auto db = QSqlDatabase::addDatabase("QSQLITE", "unittest_mbtiles_writer");
+        db.setDatabaseName(path);
+        REQUIRE(db.open());
+        QSqlQuery query(db);
+        REQUIRE(query.exec("CREATE TABLE tiles (zoom_level integer, tile_column integer, tile_row integer, tile_data blob)"));
+        REQUIRE(query.exec("CREATE UNIQUE INDEX tile_index on tiles (zoom_level, tile_column, tile_row)"));
+        db.transaction();
+        REQUIRE(query.prepare("INSERT INTO tiles VALUES (?, ?, ?, ?)"));
+        for (const auto& id : ids) {
+            query.bindValue(0, id.zoom_level);
+            query.bindValue(1, id.coords.x);
+            query.bindValue(2, id.coords.y);
+            query.bindValue(3, tile_data(id));
+            REQUIRE(query.exec());
+        }
+        db.commit();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("unittest_mbtiles_writer");
+}
+#endif
+
+void wait_for(QSignalSpy* spy, int n_signals)
+{
+    while (spy->count() < n_signals && spy->wait(10000)) { }
+}
+
+void check_source(TileSource* source)
+{
+    QSignalSpy spy(source, &TileSource::load_finished);
+    source->load({ 3, { 1, 2 } });
+    source->load({ 3, { 5, 7 } });
+    source->load({ 12, { 1, 2 } }); // not available
+    source->load({ 3, { 2, 2 } });
+    source->cancel({ 3, { 2, 2 } });
+    wait_for(&spy, 3);
+    spy.wait(50); // give the cancelled one a chance to show up
+
+    REQUIRE(spy.count() == 3);
+    std::vector<TileLayer> tiles;
+    for (const auto& arguments : spy)
+        tiles.push_back(arguments.constFirst().value<TileLayer>());
+    std::sort(tiles.begin(), tiles.end(), [](const auto& a, const auto& b) { return std::tie(a.id.zoom_level, a.id.coords.x) < std::tie(b.id.zoom_level, b.id.coords.x); });
+    CHECK(tiles[0].id == tile::Id { 3, { 1, 2 } });
+    CHECK(tiles[0].network_info.status == tile_types::NetworkInfo::Status::Good);
+    CHECK(*tiles[0].data == tile_data({ 3, { 1, 2 } }));
+    CHECK(tiles[1].id == tile::Id { 3, { 5, 7 } });
+    CHECK(tiles[1].network_info.status == tile_types::NetworkInfo::Status::Good);
+    CHECK(*tiles[1].data == tile_data({ 3, { 5, 7 } }));
+    CHECK(tiles[2].id == tile::Id { 12, { 1, 2 } });
+    CHECK(tiles[2].network_info.status == tile_types::NetworkInfo::Status::NotFound);
+    CHECK(tiles[2].data->isEmpty());
+}
+} // namespace
+
+TEST_CASE("nucleus/tile_scheduler/TileSource")
+{
+    QTemporaryDir temp_dir;
+    REQUIRE(temp_dir.isValid());
+    SECTION("tile address")
+    {
+        CHECK(TileSource::tile_address({ 2, { 1, 0 } }, TileSource::UrlPattern::ZXY) == "2/1/0");
+        CHECK(TileSource::tile_address({ 2, { 1, 0 } }, TileSource::UrlPattern::ZYX) == "2/0/1");
+        CHECK(TileSource::tile_address({ 2, { 1, 0 } }, TileSource::UrlPattern::ZXY_yPointingSouth) == "2/1/3");
+        CHECK(TileSource::tile_address({ 2, { 1, 0 } }, TileSource::UrlPattern::ZYX_yPointingSouth) == "2/3/1");
+    }
+
+    SECTION("directory")
+    {
+        write_directory(temp_dir.path(), tile_ids(3));
+        DirectoryTileSource source(temp_dir.path(), TileSource::UrlPattern::ZXY, ".png");
+        CHECK(source.build_tile_path({ 3, { 1, 2 } }) == temp_dir.path() + "/3/1/2.png");
+        check_source(&source);
+    }
+
+#ifdef ALP_ENABLE_MBTILES
+    SECTION("mbtiles")
+    {
+        const auto path = temp_dir.filePath("tiles.mbtiles");
+        write_mbtiles(path, tile_ids(3));
+        MbTilesTileSource source(path);
+        check_source(&source);
+    }
+
+    SECTION("mbtiles connections are closed on their own threads when the source is gone")
+    {
+        const auto path = temp_dir.filePath("tiles.mbtiles");
+        write_mbtiles(path, tile_ids(3));
+        const auto n_mbtiles_connections = []() {
+            const auto names = QSqlDatabase::connectionNames();
+            return std::count_if(names.cbegin(), names.cend(), [](const QString& name) { return name.startsWith("mbtiles_"); });
+        };
+        {
+            MbTilesTileSource source(path);
+            check_source(&source);
+            CHECK(n_mbtiles_connections() > 0);
+        }
+        // the pool threads close their connections on exit, which can happen after the pool was destroyed.
+        CHECK(QTest::qWaitFor([&]() { return n_mbtiles_connections() == 0; }, 5000));
+    }
+
+    SECTION("mbtiles that can't be opened report errors")
+    {
+        MbTilesTileSource source(temp_dir.filePath("does_not_exist.mbtiles"));
+        QSignalSpy spy(&source, &TileSource::load_finished);
+        source.load({ 3, { 1, 2 } });
+        wait_for(&spy, 1);
+        REQUIRE(spy.count() == 1);
+        CHECK(spy.constFirst().constFirst().value<TileLayer>().network_info.status == tile_types::NetworkInfo::Status::NetworkError);
+    }
+#endif
+}
+
+TEST_CASE("nucleus/tile_scheduler/TileSource benchmarks")
+{
+    QTemporaryDir temp_dir;
+    REQUIRE(temp_dir.isValid());
+    const auto ids = tile_ids(6); // 4096 tiles
+    write_directory(temp_dir.filePath("directory"), ids);
+
+    const auto load_all = [&ids](TileSource* source) {
+        QSignalSpy spy(source, &TileSource::load_finished);
+        for (const auto& id : ids)
+            source->load(id);
+        wait_for(&spy, int(ids.size()));
+        return spy.count();
+    };
+    DirectoryTileSource directory_source(temp_dir.filePath("directory"), TileSource::UrlPattern::ZXY, ".png");
+    BENCHMARK("directory: load 4096 tiles")
+    {
+        return load_all(&directory_source);
+    };
+#ifdef ALP_ENABLE_MBTILES
+    write_mbtiles(temp_dir.filePath("tiles.mbtiles"), ids);
+    MbTilesTileSource mbtiles_source(temp_dir.filePath("tiles.mbtiles"));
+    BENCHMARK("mbtiles: load 4096 tiles")
+    {
+        return load_all(&mbtiles_source);
+    };
+#endif
+}
@@ -111,6 +111,20 @@ TEST_CASE("tile_scheduler/utils/camera_frustum_contains_tile")
         CHECK(nucleus::tile_scheduler::utils::camera_frustum_contains_tile(cam.frustum(), tile::SrsAndHeightBounds { { -10., -10., -10. }, { 10., 1., 10. } }));
         CHECK(!nucleus::tile_scheduler::utils::camera_frustum_contains_tile(cam.frustum(), tile::SrsAndHeightBounds { { -10., -10., -10. }, { 10., -1., 10. } }));
         CHECK(!nucleus::tile_scheduler::utils::camera_frustum_contains_tile(cam.frustum(), tile::SrsAndHeightBounds { { -10., 0., -10. }, { -9., 1., -9. } }));
+
+        const auto aabbs = std::vector<tile::SrsAndHeightBounds> {
+            { { -1., 9., -1. }, { 1., 10., 1. } },
+            { { 0., 0., 0. }, { 1., 1., 1. } },
+            { { -10., -10., -10. }, { 10., 1., 10. } },
+            { { -10., -10., -10. }, { 10., -1., 10. } },
+            { { -10., 0., -10. }, { -9., 1., -9. } },
+        };
+        const auto culler = nucleus::tile_scheduler::utils::FrustumCuller(cam.frustum());
+        CHECK(culler.contains(aabbs) == std::vector { true, true, true, false, false });
+        CHECK(culler.contains(std::array { aabbs[0], aabbs[3], aabbs[4], aabbs[1] }) == std::array { true, false, false, true });
+        CHECK(culler.contains(aabbs[2]));
+        CHECK(!culler.contains(aabbs[4]));
+        CHECK(culler.contains(std::vector<tile::SrsAndHeightBounds> {}).empty());
     }
     SECTION("case 2")
     {
@@ -182,6 +196,28 @@ TEST_CASE("tile_scheduler/utils/camera_frustum_contains_tile")
             }
         }
 
+        std::vector<tile::SrsAndHeightBounds> aabbs;
+        aabbs.reserve(tile_ids.size());
+        for (const auto& tile_id : tile_ids)
+            aabbs.push_back(decorator->aabb(tile_id));
+
+        for (const auto& camera : camera_positions) {
+            const auto camera_frustum = camera.frustum();
+            const auto culler = nucleus::tile_scheduler::utils::FrustumCuller(camera_frustum);
+            const auto batched = culler.contains(aabbs);
+            REQUIRE(batched.size() == aabbs.size());
+            for (size_t i = 0; i < aabbs.size(); ++i) {
+                const auto expected = nucleus::tile_scheduler::utils::camera_frustum_contains_tile(camera_frustum, aabbs[i]);
+                CHECK(batched[i] == expected);
+                CHECK(culler.contains(aabbs[i]) == expected);
+            }
+            for (size_t i = 0; i + 4 <= aabbs.size(); i += 4) {
+                const auto four = culler.contains(std::array { aabbs[i], aabbs[i + 1], aabbs[i + 2], aabbs[i + 3] });
+                for (size_t j = 0; j < 4; ++j)
+                    CHECK(four[j] == batched[i + j]);
+            }
+        }
+
         BENCHMARK("camera_frustum_contains_tile")
         {
             bool retval = false;
@@ -195,6 +231,52 @@ TEST_CASE("tile_scheduler/utils/camera_frustum_contains_tile")
             return retval;
         };
 
+        // same input as the FrustumCuller benchmarks, without the aabb decorator lookups
+        BENCHMARK("camera_frustum_contains_tile, precomputed aabbs")
+        {
+            bool retval = false;
+            for (const auto& camera : camera_positions) {
+                const auto camera_frustum = camera.frustum();
+                for (const auto& aabb : aabbs)
+                    retval = retval != nucleus::tile_scheduler::utils::camera_frustum_contains_tile(camera_frustum, aabb);
+            }
+            return retval;
+        };
+
+        BENCHMARK("FrustumCuller, one at a time")
+        {
+            bool retval = false;
+            for (const auto& camera : camera_positions) {
+                const auto culler = nucleus::tile_scheduler::utils::FrustumCuller(camera.frustum());
+                for (const auto& aabb : aabbs)
+                    retval = retval != culler.contains(aabb);
+            }
+            return retval;
+        };
+
+        BENCHMARK("FrustumCuller, four at a time")
+        {
+            bool retval = false;
+            for (const auto& camera : camera_positions) {
+                const auto culler = nucleus::tile_scheduler::utils::FrustumCuller(camera.frustum());
+                for (size_t i = 0; i + 4 <= aabbs.size(); i += 4) {
+                    const auto four = culler.contains(std::array { aabbs[i], aabbs[i + 1], aabbs[i + 2], aabbs[i + 3] });
+                    retval = retval != ((four[0] != four[1]) != (four[2] != four[3]));
+                }
+            }
+            return retval;
+        };
+
+        BENCHMARK("FrustumCuller, whole list")
+        {
+            size_t n_visible = 0;
+            for (const auto& camera : camera_positions) {
+                const auto visible = nucleus::tile_scheduler::utils::FrustumCuller(camera.frustum()).contains(aabbs);
+                n_visible += size_t(std::count(visible.cbegin(), visible.cend(), true));
+            }
+            return n_visible;
+        };
+
         BENCHMARK("camera_frustum_contains_tile_old")
         {
             bool retval = false;